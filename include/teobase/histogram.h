@@ -0,0 +1,174 @@
+/**
+ * @file teobase/histogram.h
+ * @brief Log-linear histogram for latency measurements.
+ *
+ * Values are counted in buckets whose width grows with value, so relative
+ * error of every reported value is bounded by 2^-precision_bits while the
+ * whole range of 64-bit values takes a few kilobytes. All memory is allocated
+ * on creation. Recording is lock-free and can be done from several threads,
+ * or each thread can record into its own histogram merged later.
+ *
+ * Values have no unit, record microseconds from teotimeGetTimePassedUs(),
+ * cycles from teotimeGetCycles() or anything else and interpret results in the same unit.
+ */
+
+#pragma once
+
+#ifndef TEOBASE_HISTOGRAM_H
+#define TEOBASE_HISTOGRAM_H
+
+#include "teobase/types.h"
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Default precision, relative error of values is under 1%.
+#define TEOHISTOGRAM_DEFAULT_PRECISION_BITS 7
+
+/// Maximum supported precision.
+#define TEOHISTOGRAM_MAX_PRECISION_BITS 16
+
+/// Opaque histogram. Create it using teohistogramCreate().
+typedef struct teohistogram teohistogram;
+
+/**
+ * Creates a histogram.
+ *
+ * @param max_value The largest value to distinguish. Larger values are counted as @p max_value.
+ * @param precision_bits Amount of significant bits kept, from 1 to #TEOHISTOGRAM_MAX_PRECISION_BITS.
+ *
+ * @returns Pointer to created histogram or NULL on error.
+ */
+TEOBASE_API teohistogram* teohistogramCreate(int64_t max_value, int precision_bits);
+
+/**
+ * Destroys a histogram.
+ *
+ * @param histogram Histogram created using teohistogramCreate(). Can be NULL.
+ */
+TEOBASE_API void teohistogramDestroy(teohistogram* histogram);
+
+/**
+ * Records a value. Can be called from several threads at once.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ * @param value Value to record. Negative values are counted as zero.
+ */
+TEOBASE_API void teohistogramRecord(teohistogram* histogram, int64_t value);
+
+/**
+ * Records a value several times. Can be called from several threads at once.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ * @param value Value to record. Negative values are counted as zero.
+ * @param count How many times value occurred.
+ */
+TEOBASE_API void teohistogramRecordCount(teohistogram* histogram, int64_t value, int64_t count);
+
+/**
+ * Clears all recorded values.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ *
+ * @note Values recorded by other threads during reset may be partially lost.
+ */
+TEOBASE_API void teohistogramReset(teohistogram* histogram);
+
+/**
+ * Adds values recorded in one histogram to another, for example to merge histograms of threads.
+ *
+ * @param destination Histogram to add values to.
+ * @param source Histogram with the same precision. Its values above maximum of @p destination are counted as maximum.
+ *
+ * @returns true on success, false if precisions differ.
+ */
+TEOBASE_API bool teohistogramMerge(teohistogram* destination, const teohistogram* source);
+
+/**
+ * Gets amount of recorded values.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ *
+ * @returns The number of recorded values.
+ */
+TEOBASE_API int64_t teohistogramGetCount(const teohistogram* histogram);
+
+/**
+ * Gets the smallest recorded value.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ *
+ * @returns The smallest value, zero if histogram is empty.
+ */
+TEOBASE_API int64_t teohistogramGetMin(const teohistogram* histogram);
+
+/**
+ * Gets the largest recorded value.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ *
+ * @returns The largest value, zero if histogram is empty.
+ */
+TEOBASE_API int64_t teohistogramGetMax(const teohistogram* histogram);
+
+/**
+ * Gets arithmetic mean of recorded values.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ *
+ * @returns Mean value, zero if histogram is empty.
+ */
+TEOBASE_API double teohistogramGetMean(const teohistogram* histogram);
+
+/**
+ * Gets value at percentile.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ * @param percentile Percentile from 0 to 100, for example 99.9.
+ *
+ * @returns The largest value equivalent to the value below which @p percentile of recorded values fall,
+ * not larger than teohistogramGetMax(). Zero if histogram is empty.
+ */
+TEOBASE_API int64_t teohistogramGetValueAtPercentile(const teohistogram* histogram, double percentile);
+
+/**
+ * Gets buffer size enough for teohistogramSerialize() with any recorded values.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ *
+ * @returns Size in bytes.
+ */
+TEOBASE_API size_t teohistogramGetMaxSerializedSize(const teohistogram* histogram);
+
+/**
+ * Stores histogram in compact binary form.
+ *
+ * Bucket counts are written as variable length integers, runs of empty buckets
+ * take one or two bytes, so typical latency histogram takes a few hundred bytes.
+ *
+ * @param histogram Histogram created using teohistogramCreate().
+ * @param buffer A pointer to the buffer to store data.
+ * @param buffer_size The length of buffer in bytes.
+ *
+ * @returns Amount of bytes written, zero if buffer is too small.
+ */
+TEOBASE_API size_t teohistogramSerialize(const teohistogram* histogram, uint8_t* buffer, size_t buffer_size);
+
+/**
+ * Creates a histogram from data stored by teohistogramSerialize().
+ *
+ * @param buffer A pointer to the buffer with data.
+ * @param buffer_size The length of data in bytes.
+ *
+ * @returns Pointer to created histogram or NULL if data is malformed.
+ */
+TEOBASE_API teohistogram* teohistogramDeserialize(const uint8_t* buffer, size_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file teobase/packet.h
+ * @brief Pool of reference counted packet buffers for the receive path.
+ *
+ * All packets of a pool are allocated at once in one cache line aligned region,
+ * optionally backed by huge pages. Threads take and return packets through
+ * their own teosockPacketCache, which exchanges packets with shared pool
+ * free list in batches, so packets can be passed between threads and returned
+ * without calling malloc() or taking a lock on every packet.
+ */
+
+#pragma once
+
+#ifndef TEOBASE_PACKET_H
+#define TEOBASE_PACKET_H
+
+#include "teobase/types.h"
+
+#include "teobase/socket.h"
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Alignment of packets and their payload in bytes.
+#define TEOSOCK_PACKET_ALIGNMENT 64
+
+/// Maximum amount of packets kept in per-thread cache.
+#define TEOSOCK_PACKET_CACHE_SIZE 64
+
+/// Maximum amount of packets received by one teosockRecvfromPacketBatch() call.
+#define TEOSOCK_PACKET_BATCH_SIZE 64
+
+/// Opaque packet pool. Create it using teosockPacketPoolCreate().
+typedef struct teosockPacketPool teosockPacketPool;
+
+/// Enumeration with bit flags for teosockPacketPoolCreate() function.
+typedef enum teosockPacketPoolFlags {
+    /// Back pool memory by huge pages. Falls back to transparent huge pages or regular pages. Linux only.
+    TEOSOCK_PACKET_POOL_HUGEPAGES = 1 << 0,
+} teosockPacketPoolFlags;
+
+/// Packet buffer taken from a pool.
+typedef struct teosockPacket {
+    uint8_t* data;  ///< Payload buffer, aligned to #TEOSOCK_PACKET_ALIGNMENT.
+    size_t capacity;  ///< The length of payload buffer in bytes.
+    size_t length;  ///< The length of data stored in payload buffer.
+    struct sockaddr_storage address;  ///< Sender address of received packet.
+    socklen_t address_length;  ///< The length of address stored in @a address.
+    teosockPacketPool* pool;  ///< Pool the packet belongs to. Do not modify.
+    struct teosockPacket* next;  ///< Free list link. Do not modify.
+    volatile int32_t reference_count;  ///< Reference counter. Use teosockPacketRetain() and teosockPacketRelease().
+} teosockPacket;
+
+/// Per-thread packet cache. Initialize it using teosockPacketCacheInit(), do not modify fields directly.
+typedef struct teosockPacketCache {
+    teosockPacketPool* pool;  ///< Pool the cache takes packets from.
+    size_t count;  ///< The number of packets in @a packets array.
+    teosockPacket* packets[TEOSOCK_PACKET_CACHE_SIZE];  ///< Cached free packets.
+} teosockPacketCache;
+
+/**
+ * Creates a packet pool.
+ *
+ * @param packet_size Payload size of each packet in bytes, rounded up to #TEOSOCK_PACKET_ALIGNMENT.
+ * @param packets_count The number of packets in pool.
+ * @param flags A combination of teosockPacketPoolFlags.
+ *
+ * @returns Pointer to created pool or NULL on error.
+ */
+TEOBASE_API teosockPacketPool* teosockPacketPoolCreate(size_t packet_size, size_t packets_count, int flags);
+
+/**
+ * Destroys a packet pool.
+ *
+ * @param pool Pool created using teosockPacketPoolCreate(). Can be NULL.
+ *
+ * @note All packets must be released and all caches flushed before destroying the pool.
+ */
+TEOBASE_API void teosockPacketPoolDestroy(teosockPacketPool* pool);
+
+/**
+ * Gets amount of packets in pool free list. Packets held in caches are not counted.
+ *
+ * @param pool Pool created using teosockPacketPoolCreate().
+ *
+ * @returns The number of free packets.
+ */
+TEOBASE_API size_t teosockPacketPoolGetFreeCount(teosockPacketPool* pool);
+
+/**
+ * Initializes per-thread packet cache.
+ *
+ * @param cache Cache to initialize. Must be used by one thread at a time.
+ * @param pool Pool created using teosockPacketPoolCreate().
+ */
+TEOBASE_API void teosockPacketCacheInit(teosockPacketCache* cache, teosockPacketPool* pool);
+
+/**
+ * Returns all cached packets to pool. Call it before thread exits.
+ *
+ * @param cache Cache initialized using teosockPacketCacheInit().
+ */
+TEOBASE_API void teosockPacketCacheFlush(teosockPacketCache* cache);
+
+/**
+ * Takes a packet from cache or pool. Reference count of returned packet is one, length is zero.
+ *
+ * @param cache Cache initialized using teosockPacketCacheInit().
+ *
+ * @returns Pointer to packet or NULL if pool is exhausted.
+ */
+TEOBASE_API teosockPacket* teosockPacketAlloc(teosockPacketCache* cache);
+
+/**
+ * Increments packet reference count. Use it to share packet between several owners.
+ *
+ * @param packet Packet taken using teosockPacketAlloc().
+ */
+TEOBASE_API void teosockPacketRetain(teosockPacket* packet);
+
+/**
+ * Decrements packet reference count. Packet is returned to cache when count drops to zero.
+ *
+ * Packet may be released by any thread, not only by the thread which took it.
+ * Packet of another pool than the pool of @p cache is returned directly to its own pool.
+ *
+ * @param cache Cache of the calling thread.
+ * @param packet Packet taken using teosockPacketAlloc().
+ */
+TEOBASE_API void teosockPacketRelease(teosockPacketCache* cache, teosockPacket* packet);
+
+/**
+ * Receives a datagram into a packet taken from cache.
+ *
+ * @param socket_descriptor Socket descriptor.
+ * @param cache Cache initialized using teosockPacketCacheInit().
+ * @param packet [out] Received packet if data was received. Release it after processing.
+ * @param error_code [out] A null pointer, or points to a variable in which the error code is to be stored.
+ *
+ * @returns Result of operation. TEOSOCK_RECVFROM_TRY_AGAIN with ENOBUFS error code if pool is exhausted.
+ */
+TEOBASE_API teosockRecvfromResult teosockRecvfromPacket(
+    teonetSocket socket_descriptor,
+    teosockPacketCache* cache,
+    teosockPacket** packet,
+    int* error_code);
+
+/**
+ * Receives several datagrams into packets taken from cache using teosockRecvfromBatch().
+ *
+ * @param socket_descriptor Socket descriptor.
+ * @param cache Cache initialized using teosockPacketCacheInit().
+ * @param packets [out] An array to store received packets. Release them after processing.
+ * @param packets_count The number of elements in @p packets array. At most #TEOSOCK_PACKET_BATCH_SIZE
+ * packets are received per call, call again to receive more.
+ * @param received_count [out] The number of received packets.
+ * @param error_code [out] A null pointer, or points to a variable in which the error code is to be stored.
+ *
+ * @returns Result of operation. TEOSOCK_RECVFROM_TRY_AGAIN with ENOBUFS error code if pool is exhausted.
+ */
+TEOBASE_API teosockRecvfromResult teosockRecvfromPacketBatch(
+    teonetSocket socket_descriptor,
+    teosockPacketCache* cache,
+    teosockPacket** packets,
+    size_t packets_count,
+    size_t* received_count,
+    int* error_code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
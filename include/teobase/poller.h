@@ -0,0 +1,133 @@
+/**
+ * @file teobase/poller.h
+ * @brief Multi-socket readiness poller. Uses epoll on Linux and poll() elsewhere.
+ */
+
+#pragma once
+
+#ifndef TEOBASE_POLLER_H
+#define TEOBASE_POLLER_H
+
+#include "teobase/types.h"
+
+#include "teobase/socket.h"
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Opaque poller object. Create it using teosockPollerCreate().
+typedef struct teosockPoller teosockPoller;
+
+/// Enumeration with bit flags for socket events and registration options of teosockPoller.
+typedef enum teosockPollerEvents {
+    TEOSOCK_POLLER_READ = 1 << 0,  ///< Socket is readable or have pending connection.
+    TEOSOCK_POLLER_WRITE = 1 << 1,  ///< Socket is writable.
+    TEOSOCK_POLLER_ERROR = 1 << 2,  ///< Error condition on socket. Always reported, no need to request it.
+    TEOSOCK_POLLER_HANGUP = 1 << 3,  ///< Peer closed connection. Always reported, no need to request it.
+    /// Registration option. Report events only when socket state changes, instead of while it persists.
+    /// Socket must be drained until operation would block after each event.
+    /// @note Supported only on Linux, poll() fallback treats all sockets as level-triggered.
+    TEOSOCK_POLLER_EDGE_TRIGGERED = 1 << 4,
+} teosockPollerEvents;
+
+/// Description of event returned by teosockPollerWait() function.
+typedef struct teosockPollerEvent {
+    teonetSocket socket_descriptor;  ///< Socket on which events occurred.
+    int events;  ///< A combination of teosockPollerEvents flags that occurred.
+    void* user_data;  ///< Pointer that was passed when socket was registered.
+} teosockPollerEvent;
+
+/**
+ * Creates a poller object.
+ *
+ * @returns Pointer to created poller or NULL on error.
+ *
+ * @note Poller is not thread-safe, register sockets and wait for events from one thread.
+ */
+TEOBASE_API teosockPoller* teosockPollerCreate(void);
+
+/**
+ * Destroys a poller object. Registered sockets are not closed.
+ *
+ * @param poller Poller created using teosockPollerCreate(). Can be NULL.
+ */
+TEOBASE_API void teosockPollerDestroy(teosockPoller* poller);
+
+/**
+ * Registers a socket in poller.
+ *
+ * @param poller Poller created using teosockPollerCreate().
+ * @param socket_descriptor Socket to watch.
+ * @param events A combination of TEOSOCK_POLLER_READ, TEOSOCK_POLLER_WRITE and TEOSOCK_POLLER_EDGE_TRIGGERED flags.
+ * @param user_data Pointer to return in events of this socket.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or socket is already registered.
+ */
+TEOBASE_API int teosockPollerAdd(
+    teosockPoller* poller,
+    teonetSocket socket_descriptor,
+    int events,
+    void* user_data);
+
+/**
+ * Changes watched events and user data of registered socket.
+ *
+ * @param poller Poller created using teosockPollerCreate().
+ * @param socket_descriptor Socket registered using teosockPollerAdd().
+ * @param events A combination of TEOSOCK_POLLER_READ, TEOSOCK_POLLER_WRITE and TEOSOCK_POLLER_EDGE_TRIGGERED flags.
+ * @param user_data Pointer to return in events of this socket.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or socket is not registered.
+ */
+TEOBASE_API int teosockPollerModify(
+    teosockPoller* poller,
+    teonetSocket socket_descriptor,
+    int events,
+    void* user_data);
+
+/**
+ * Unregisters socket from poller. Call it before closing registered socket.
+ *
+ * @param poller Poller created using teosockPollerCreate().
+ * @param socket_descriptor Socket registered using teosockPollerAdd().
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or socket is not registered.
+ */
+TEOBASE_API int teosockPollerRemove(teosockPoller* poller, teonetSocket socket_descriptor);
+
+/**
+ * Waits for events on registered sockets.
+ *
+ * Refreshes cached time of the calling thread after waking up, see teotimeGetCachedTimeMs().
+ *
+ * @param poller Poller created using teosockPollerCreate().
+ * @param events An array to store occurred events.
+ * @param max_events The number of elements in @p events array.
+ * @param timeout_ms The amount of time to wait in milliseconds, negative value to wait infinitely.
+ *
+ * @returns The number of events stored in @p events array, zero on timeout
+ * or interruption by signal, TEOSOCK_SOCKET_ERROR on error.
+ */
+TEOBASE_API int teosockPollerWait(
+    teosockPoller* poller,
+    teosockPollerEvent* events,
+    int max_events,
+    int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file teobase/resolver.h
+ * @brief Thread-safe host name resolver with in-process cache.
+ *
+ * Successful resolutions are cached for a configured time to live,
+ * failed resolutions are cached for a shorter negative time to live.
+ * Optionally entries that are about to expire are refreshed in background
+ * while the cached value is still returned.
+ */
+
+#pragma once
+
+#ifndef TEOBASE_RESOLVER_H
+#define TEOBASE_RESOLVER_H
+
+#include "teobase/types.h"
+
+#include "teobase/socket.h"
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Maximum amount of addresses stored for one host name.
+#define TEOSOCK_RESOLVER_MAX_ADDRESSES 16
+
+/// Maximum length of cached host name including terminating null character. Longer names are resolved without caching.
+#define TEOSOCK_RESOLVER_MAX_HOST_LENGTH 256
+
+/// Resolved address of a host.
+typedef struct teosockResolvedAddress {
+    struct sockaddr_storage address;  ///< Socket address with port set.
+    socklen_t address_length;  ///< The length of address stored in @a address.
+    int family;  ///< Address family, AF_INET or AF_INET6.
+} teosockResolvedAddress;
+
+/// Addresses of a host in order returned by system resolver.
+typedef struct teosockResolvedAddresses {
+    teosockResolvedAddress addresses[TEOSOCK_RESOLVER_MAX_ADDRESSES];  ///< Resolved addresses.
+    size_t count;  ///< The number of valid elements in @a addresses array.
+} teosockResolvedAddresses;
+
+/// Result enumeration for resolver functions.
+typedef enum teosockResolveResult {
+    TEOSOCK_RESOLVE_SUCCESS = 0,  ///< Host was resolved, addresses are stored.
+    TEOSOCK_RESOLVE_PENDING = 1,  ///< Host is being resolved in background. Try again later.
+    TEOSOCK_RESOLVE_NOT_FOUND = -1,  ///< Failed to resolve host.
+} teosockResolveResult;
+
+/// Resolver cache configuration.
+typedef struct teosockResolverConfig {
+    int64_t ttl_ms;  ///< Time to live of successful resolution, in milliseconds. Zero disables caching.
+    int64_t negative_ttl_ms;  ///< Time to live of failed resolution, in milliseconds. Zero disables negative caching.
+    int64_t refresh_ahead_ms;  ///< Entries expiring within this time are refreshed in background if @a async_refresh is set.
+    bool async_refresh;  ///< Refresh entries in background thread before they expire.
+    size_t max_entries;  ///< Maximum amount of cached host names. Least recently used entries are evicted.
+} teosockResolverConfig;
+
+/**
+ * Get default resolver configuration.
+ *
+ * Default configuration caches hosts for 60 seconds, failures for 5 seconds,
+ * keeps up to 256 entries and does not refresh entries in background.
+ *
+ * @param config [out] Configuration to fill.
+ */
+TEOBASE_API void teosockResolverGetDefaultConfig(teosockResolverConfig* config);
+
+/**
+ * Set resolver configuration. Cached entries are kept.
+ *
+ * @param config Configuration to apply.
+ */
+TEOBASE_API void teosockResolverConfigure(const teosockResolverConfig* config);
+
+/**
+ * Resolves host name using cache. Blocks calling thread if host is not cached.
+ *
+ * IP address literals are converted without using cache.
+ *
+ * @param host Host name or IP address.
+ * @param port Port to set in resolved addresses.
+ * @param addresses [out] Resolved addresses.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_RESOLVE_SUCCESS if host was resolved.
+ * @retval TEOSOCK_RESOLVE_NOT_FOUND if failed to resolve host.
+ */
+TEOBASE_API teosockResolveResult teosockResolve(
+    const char* host,
+    uint16_t port,
+    teosockResolvedAddresses* addresses);
+
+/**
+ * Resolves host name using cache without blocking.
+ *
+ * If host is not cached, resolution is queued to a small pool of background threads
+ * and TEOSOCK_RESOLVE_PENDING is returned. Call the function again later to get result.
+ *
+ * Hosts which can not be cached, because cache is disabled, full of pending resolutions
+ * or host name is too long, are also resolved in background. Their result is returned
+ * once, the next call after that starts a new resolution. Result which is not collected
+ * within negative time to live, but at least a second, is dropped.
+ *
+ * @param host Host name or IP address.
+ * @param port Port to set in resolved addresses.
+ * @param addresses [out] Resolved addresses.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_RESOLVE_SUCCESS if host was resolved.
+ * @retval TEOSOCK_RESOLVE_PENDING if host is being resolved in background.
+ * @retval TEOSOCK_RESOLVE_NOT_FOUND if failed to resolve host.
+ */
+TEOBASE_API teosockResolveResult teosockResolveNonBlocking(
+    const char* host,
+    uint16_t port,
+    teosockResolvedAddresses* addresses);
+
+/**
+ * Removes all entries from resolver cache.
+ */
+TEOBASE_API void teosockResolverFlush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
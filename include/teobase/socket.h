@@ -72,9 +72,62 @@ typedef enum {
  */
 TEOBASE_API teonetSocket teosockCreateTcp(void);
 
+/**
+ * Creates a UDP socket.
+ *
+ * @returns TEOSOCK_INVALID_SOCKET on error, socket handle otherwise.
+ */
+TEOBASE_API teonetSocket teosockCreateUdp(void);
+
+/// Type of sockets created by teosockCreateReuseportGroup().
+typedef enum teosockSocketType {
+    TEOSOCK_SOCKET_TYPE_UDP = 0,  ///< Bound UDP sockets.
+    TEOSOCK_SOCKET_TYPE_TCP_LISTEN = 1,  ///< Bound TCP sockets in listening state.
+} teosockSocketType;
+
+/// Method of distributing incoming traffic between sockets of a reuseport group.
+typedef enum teosockReuseportSteering {
+    TEOSOCK_REUSEPORT_STEERING_HASH = 0,  ///< Kernel default, socket is selected by hash of the flow.
+    TEOSOCK_REUSEPORT_STEERING_INCOMING_CPU = 1,  ///< Socket with index N prefers traffic received on CPU N (SO_INCOMING_CPU). Linux only.
+    TEOSOCK_REUSEPORT_STEERING_CPU_BPF = 2,  ///< Classic BPF program selects socket with index of receiving CPU modulo group size. Linux only.
+} teosockReuseportSteering;
+
+/// Maximum amount of sockets in a reuseport group.
+#define TEOSOCK_REUSEPORT_MAX_SOCKETS 256
+
+/**
+ * Creates a group of sockets bound to the same address and port using SO_REUSEPORT.
+ *
+ * Kernel distributes incoming datagrams or connections between sockets of the group,
+ * so each socket can be served by its own worker thread. With CPU steering
+ * socket with index N should be served by thread pinned to CPU N.
+ *
+ * @param type Type of sockets to create.
+ * @param address IP address to bind to, NULL to bind to any IPv4 address.
+ * @param port Port to bind to. If zero, the first socket gets ephemeral port and the rest join it.
+ * @param steering Method of distributing traffic between sockets.
+ * @param sockets [out] An array to store created sockets.
+ * @param sockets_count The number of sockets to create.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if all sockets were created.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed, no sockets are left open.
+ *
+ * @note Groups of more than one socket are not supported on platforms without SO_REUSEPORT.
+ */
+TEOBASE_API int teosockCreateReuseportGroup(
+    teosockSocketType type,
+    const char* address,
+    uint16_t port,
+    teosockReuseportSteering steering,
+    teonetSocket* sockets,
+    size_t sockets_count);
+
 /// Result enumeration for teosockConnect() function.
 typedef enum teosockConnectResult {
     TEOSOCK_CONNECT_SUCCESS = 1,  ///< Successful connection.
+    TEOSOCK_CONNECT_PENDING = 0,  ///< Asynchronous connection is still in progress.
     TEOSOCK_CONNECT_HOST_NOT_FOUND = -1,  ///< Failed to resolve host address.
     TEOSOCK_CONNECT_FAILED = -2,  ///< Failed to connect to server.
 } teosockConnectResult;
@@ -97,6 +150,174 @@ TEOBASE_API teosockConnectResult teosockConnect(
     const char* server,
     uint16_t port);
 
+/**
+ * Establishes a connection to a specified server sending first data in SYN packet (TCP Fast Open).
+ *
+ * Uses sendto() with MSG_FASTOPEN on Linux. If there is no Fast Open cookie for the server yet,
+ * the kernel requests one and connects normally, @p sent_length is zero in this case for
+ * non-blocking socket and data must be sent after connection is established.
+ * If Fast Open is not supported, connects like teosockConnect().
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ * @param server Server IP address or domain name.
+ * @param port Port to connect to.
+ * @param data A pointer to the buffer with first data to send.
+ * @param length The length of data in bytes.
+ * @param sent_length [out] Amount of sent bytes.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_CONNECT_SUCCESS if connection was established or is in progress.
+ * @retval TEOSOCK_CONNECT_HOST_NOT_FOUND if failed to resolve host address.
+ * @retval TEOSOCK_CONNECT_FAILED if failed to connect to server.
+ *
+ * @note Data in SYN packet may be delivered twice, send only idempotent requests this way.
+ */
+TEOBASE_API teosockConnectResult teosockConnectFastOpen(
+    teonetSocket socket_descriptor,
+    const char* server,
+    uint16_t port,
+    const uint8_t* data,
+    size_t length,
+    size_t* sent_length);
+
+/**
+ * Enables TCP Fast Open for teosockConnect() on a socket (TCP_FASTOPEN_CONNECT).
+ *
+ * Call it before teosockConnect(). Connect then returns immediately without sending SYN,
+ * and SYN is sent together with data of the first teosockSend() call. If there is
+ * no Fast Open cookie for the server yet, the kernel falls back to regular handshake.
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or is not supported by the platform.
+ *
+ * @note Not useful with teosockConnectTimeout(), which creates its own sockets and
+ * needs completed handshakes to pick the fastest address.
+ */
+TEOBASE_API int teosockSetFastOpenConnect(teonetSocket socket_descriptor);
+
+/**
+ * Enables accepting TCP Fast Open connections on a listening socket.
+ *
+ * @param socket_descriptor Listening socket descriptor.
+ * @param queue_length Maximum amount of pending Fast Open requests without completed handshake.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or is not supported by the platform.
+ *
+ * @note On Linux server side Fast Open must be allowed by net.ipv4.tcp_fastopen sysctl (bit 2).
+ */
+TEOBASE_API int teosockSetFastOpenListen(teonetSocket socket_descriptor, int queue_length);
+
+/// Type of Unix domain socket.
+typedef enum teosockUnixType {
+    TEOSOCK_UNIX_STREAM = 0,  ///< Connection-mode socket, like TCP.
+    TEOSOCK_UNIX_DATAGRAM = 1,  ///< Reliable datagram socket preserving message boundaries.
+} teosockUnixType;
+
+/// Maximum amount of file descriptors passed in one message.
+#define TEOSOCK_UNIX_MAX_DESCRIPTORS 16
+
+/**
+ * Creates a Unix domain socket for local inter-process communication.
+ *
+ * Local traffic over Unix domain sockets skips TCP/IP stack. Send, receive
+ * and poll functions of this module work with these sockets unchanged.
+ *
+ * @param type Type of socket.
+ *
+ * @returns TEOSOCK_INVALID_SOCKET on error or on Windows, socket handle otherwise.
+ */
+TEOBASE_API teonetSocket teosockCreateUnix(teosockUnixType type);
+
+/**
+ * Binds a Unix domain socket to a path.
+ *
+ * For stream socket call listen() and accept() after binding.
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateUnix() function.
+ * @param path File system path, or name starting with '@' for Linux abstract namespace.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed, for example path exists or is too long.
+ *
+ * @note Socket file is not removed when socket is closed, unlink it before binding again.
+ */
+TEOBASE_API int teosockBindUnix(teonetSocket socket_descriptor, const char* path);
+
+/**
+ * Connects a Unix domain socket to a path.
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateUnix() function.
+ * @param path File system path, or name starting with '@' for Linux abstract namespace.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_CONNECT_SUCCESS if connection successfully established or is in progress.
+ * @retval TEOSOCK_CONNECT_HOST_NOT_FOUND if path is invalid.
+ * @retval TEOSOCK_CONNECT_FAILED if failed to connect, including full listen backlog (EAGAIN) of non-blocking socket.
+ */
+TEOBASE_API teosockConnectResult teosockConnectUnix(teonetSocket socket_descriptor, const char* path);
+
+/**
+ * Creates a pair of connected Unix domain sockets.
+ *
+ * @param type Type of sockets.
+ * @param sockets [out] An array to store two connected sockets.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or is not supported by the platform.
+ */
+TEOBASE_API int teosockCreateUnixPair(teosockUnixType type, teonetSocket sockets[2]);
+
+/**
+ * Sends data together with file descriptors over a Unix domain socket (SCM_RIGHTS).
+ *
+ * @param socket_descriptor Connected Unix domain socket.
+ * @param data A pointer to the buffer with data. At least one byte must be sent with descriptors.
+ * @param length The length of data in bytes.
+ * @param descriptors An array of file descriptors to pass. Receiver gets their duplicates.
+ * @param descriptors_count The number of descriptors, not more than #TEOSOCK_UNIX_MAX_DESCRIPTORS.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of sent bytes otherwise.
+ */
+TEOBASE_API ssize_t teosockSendDescriptors(
+    teonetSocket socket_descriptor,
+    const uint8_t* data,
+    size_t length,
+    const int* descriptors,
+    size_t descriptors_count);
+
+/**
+ * Receives data together with file descriptors over a Unix domain socket (SCM_RIGHTS).
+ *
+ * @param socket_descriptor Connected Unix domain socket.
+ * @param data A pointer to the buffer to store the data.
+ * @param length The length of buffer in bytes.
+ * @param descriptors [out] An array to store received file descriptors. Caller owns and closes them.
+ * @param max_descriptors The number of elements in @p descriptors array. Extra descriptors are closed.
+ * @param descriptors_count [out] The number of received descriptors.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of received bytes otherwise.
+ */
+TEOBASE_API ssize_t teosockRecvDescriptors(
+    teonetSocket socket_descriptor,
+    uint8_t* data,
+    size_t length,
+    int* descriptors,
+    size_t max_descriptors,
+    size_t* descriptors_count);
+
 /**
  * Establishes a connection to a specified server.
  *
@@ -112,6 +333,7 @@ TEOBASE_API teosockConnectResult teosockConnect(
  * @retval TEOSOCK_CONNECT_FAILED if failed to connect to server.
  *
  * @note Socket will be left in non-blocking mode.
+ * @note Same as teosockConnectParallel() with #TEOSOCK_CONNECT_ATTEMPT_DELAY_MS delay.
  */
 TEOBASE_API teosockConnectResult teosockConnectTimeout(
     teonetSocket* socket_descriptor,
@@ -119,6 +341,121 @@ TEOBASE_API teosockConnectResult teosockConnectTimeout(
     uint16_t port,
     int timeout_ms);
 
+/// Default delay before starting connection attempt to next server address, recommended by RFC 8305.
+#define TEOSOCK_CONNECT_ATTEMPT_DELAY_MS 250
+
+/**
+ * Establishes a connection trying several server addresses concurrently (Happy Eyeballs, RFC 8305).
+ *
+ * Resolved addresses are ordered alternating IPv6 and IPv4 families. Connection attempts
+ * are started one by one every @p attempt_delay_ms milliseconds, or immediately after
+ * previous attempt failed, and are kept in flight together. The first established
+ * connection is returned, other attempts are closed.
+ *
+ * @param socket_descriptor [out] A pointer to store connected socket descriptor.
+ * @param server Server IP address or domain name.
+ * @param port Port to connect to.
+ * @param timeout_ms Maximum amount of time to wait for all attempts, in milliseconds.
+ * @param attempt_delay_ms Delay before starting attempt to next address, in milliseconds.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_CONNECT_SUCCESS if connection successfully established.
+ * @retval TEOSOCK_CONNECT_HOST_NOT_FOUND if failed to resolve host address.
+ * @retval TEOSOCK_CONNECT_FAILED if failed to connect to server.
+ *
+ * @note Socket will be left in non-blocking mode.
+ */
+TEOBASE_API teosockConnectResult teosockConnectParallel(
+    teonetSocket* socket_descriptor,
+    const char* server,
+    uint16_t port,
+    int timeout_ms,
+    int attempt_delay_ms);
+
+/// Maximum amount of simultaneous connection attempts to different server addresses.
+#define TEOSOCK_CONNECT_MAX_ATTEMPTS 8
+
+/// Opaque asynchronous connection. Start it using teosockConnectAsync().
+typedef struct teosockAsyncConnect teosockAsyncConnect;
+
+/**
+ * Starts asynchronous connection to a specified server.
+ *
+ * Works like teosockConnectParallel() but never blocks. Host name is resolved
+ * in background using teosockResolveNonBlocking(), connection attempts are
+ * non-blocking. Drive the connection from caller's event loop:
+ * wait until one of teosockConnectAsyncGetSockets() sockets becomes writable
+ * or teosockConnectAsyncGetTimeout() milliseconds pass, then call
+ * teosockConnectAsyncProcess(), until it returns a result other than
+ * TEOSOCK_CONNECT_PENDING.
+ *
+ * @param server Server IP address or domain name.
+ * @param port Port to connect to.
+ * @param timeout_ms Maximum amount of time for resolution and all attempts, in milliseconds.
+ * @param attempt_delay_ms Delay before starting attempt to next address, in milliseconds.
+ *
+ * @returns Pointer to created connection or NULL on error.
+ */
+TEOBASE_API teosockAsyncConnect* teosockConnectAsync(
+    const char* server,
+    uint16_t port,
+    int timeout_ms,
+    int attempt_delay_ms);
+
+/**
+ * Advances asynchronous connection: checks resolution, checks results of attempts
+ * in flight and starts new attempts when their delay passed.
+ *
+ * @param async_connect Connection started using teosockConnectAsync().
+ * @param socket_descriptor [out] A pointer to store connected socket descriptor.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_CONNECT_PENDING if connection is still in progress.
+ * @retval TEOSOCK_CONNECT_SUCCESS if connection successfully established.
+ * @retval TEOSOCK_CONNECT_HOST_NOT_FOUND if failed to resolve host address.
+ * @retval TEOSOCK_CONNECT_FAILED if failed to connect to server.
+ *
+ * @note Connected socket is in non-blocking mode and is owned by caller,
+ * teosockConnectAsyncDestroy() does not close it.
+ */
+TEOBASE_API teosockConnectResult teosockConnectAsyncProcess(
+    teosockAsyncConnect* async_connect,
+    teonetSocket* socket_descriptor);
+
+/**
+ * Gets sockets of connection attempts in flight to wait for writability.
+ *
+ * Sockets change after every teosockConnectAsyncProcess() call.
+ *
+ * @param async_connect Connection started using teosockConnectAsync().
+ * @param sockets [out] An array to store sockets.
+ * @param max_sockets The number of elements in @p sockets array, #TEOSOCK_CONNECT_MAX_ATTEMPTS is enough.
+ *
+ * @returns The number of stored sockets.
+ */
+TEOBASE_API size_t teosockConnectAsyncGetSockets(
+    const teosockAsyncConnect* async_connect,
+    teonetSocket* sockets,
+    size_t max_sockets);
+
+/**
+ * Gets time after which teosockConnectAsyncProcess() must be called even if no socket became ready.
+ *
+ * @param async_connect Connection started using teosockConnectAsync().
+ *
+ * @returns Time in milliseconds, zero if connection should be processed immediately.
+ */
+TEOBASE_API int teosockConnectAsyncGetTimeout(const teosockAsyncConnect* async_connect);
+
+/**
+ * Cancels asynchronous connection if it is still in progress and frees its resources.
+ *
+ * @param async_connect Connection started using teosockConnectAsync(). Can be NULL.
+ */
+TEOBASE_API void teosockConnectAsyncDestroy(teosockAsyncConnect* async_connect);
+
 /**
  * Receives data from a connected socket.
  *
@@ -164,6 +501,41 @@ TEOBASE_API teosockRecvfromResult teosockRecvfrom(
     size_t* received_length,
     int* error_code);
 
+/// Description of one datagram slot for teosockRecvfromBatch() function.
+typedef struct teosockRecvfromMessage {
+    uint8_t* buffer;  ///< [in] A pointer to the buffer to store the datagram.
+    size_t buffer_size;  ///< [in] The length of @a buffer in bytes.
+    struct sockaddr_storage address;  ///< [out] Address of the datagram sender.
+    socklen_t address_length;  ///< [out] The length of sender address stored in @a address.
+    size_t received_length;  ///< [out] The length of received datagram in bytes.
+} teosockRecvfromMessage;
+
+/**
+ * Receives several datagrams from a connectionless-mode socket in one call.
+ *
+ * Uses recvmmsg() on Linux and falls back to a loop over teosockRecvfrom() on
+ * other platforms. Waits only for the first datagram if socket is in blocking
+ * mode, remaining slots are filled with datagrams that are already queued.
+ *
+ * @param[in] socket_descriptor Socket descriptor of a datagram socket.
+ * @param[in,out] messages An array of datagram slots. Buffers must be set by the caller.
+ * @param[in] messages_count The number of slots in @a messages array, must not be zero.
+ * @param[out] received_count A null pointer, or points to a variable in which the number of filled slots is to be stored.
+ * Zero is stored if nothing was received.
+ * @param[out] error_code A null pointer, or points to a variable in which the error code is to be stored.
+ *
+ * @returns Result of operation. Values have the same meaning as for teosockRecvfrom().
+ * TEOSOCK_RECVFROM_DATA_RECEIVED is returned if at least one datagram was received.
+ * Zero-length datagram fills a slot with @a received_length of zero, TEOSOCK_RECVFROM_ORDERLY_CLOSED is never returned.
+ * TEOSOCK_RECVFROM_UNKNOWN_ERROR with EINVAL error code is returned if @a messages_count is zero.
+ */
+TEOBASE_API teosockRecvfromResult teosockRecvfromBatch(
+    teonetSocket socket_descriptor,
+    teosockRecvfromMessage* messages,
+    size_t messages_count,
+    size_t* received_count,
+    int* error_code);
+
 /**
  * Sends data on a connected socket.
  *
@@ -181,6 +553,392 @@ TEOBASE_API ssize_t teosockSend(
     const uint8_t* data,
     size_t length);
 
+/**
+ * Sends a range of a file on a connected socket.
+ *
+ * Uses sendfile() on Linux, so data is not copied through user space.
+ * Other platforms read the file into a buffer and send it with teosockSend().
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ * @param file_descriptor Descriptor of file opened for reading.
+ * @param offset [in,out] File offset to send from. Advanced by amount of sent bytes.
+ * @param length Maximum amount of bytes to send.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, zero at end of file, amount of sent bytes otherwise.
+ *
+ * @note Amount of bytes sent can be less than requested, call again with advanced offset.
+ * For non-blocking socket error code is EAGAIN when socket buffer is full.
+ */
+TEOBASE_API ssize_t teosockSendFile(
+    teonetSocket socket_descriptor,
+    int file_descriptor,
+    int64_t* offset,
+    size_t length);
+
+/// Requested size of pipe used by teosockRelay on Linux.
+#define TEOSOCK_RELAY_PIPE_SIZE (1024 * 1024)
+
+/// Opaque relay for forwarding data between sockets. Create it using teosockRelayCreate().
+typedef struct teosockRelay teosockRelay;
+
+/// Result enumeration for teosockRelayForward() function.
+typedef enum teosockRelayResult {
+    TEOSOCK_RELAY_SUCCESS = 0,  ///< Some data was forwarded, operation stopped because a socket would block.
+    TEOSOCK_RELAY_TRY_AGAIN = 1,  ///< No data was forwarded. Wait for destination writability if pending length is not zero, for source readability otherwise.
+    TEOSOCK_RELAY_CLOSED = 2,  ///< Source was orderly shut down and all its data was forwarded.
+    TEOSOCK_RELAY_ERROR = -1,  ///< Socket error occurred. Error code is kept in errno or WSAGetLastError().
+} teosockRelayResult;
+
+/**
+ * Creates a relay for forwarding data between sockets.
+ *
+ * Uses a pipe and splice() on Linux, so data is not copied through user space.
+ * Other platforms forward data through a user space buffer.
+ *
+ * @returns Pointer to created relay or NULL on error.
+ *
+ * @note Use one relay per direction of forwarded stream.
+ */
+TEOBASE_API teosockRelay* teosockRelayCreate(void);
+
+/**
+ * Destroys a relay. Pending data is lost.
+ *
+ * @param relay Relay created using teosockRelayCreate(). Can be NULL.
+ */
+TEOBASE_API void teosockRelayDestroy(teosockRelay* relay);
+
+/**
+ * Forwards data from one connected socket to another until one of them would block.
+ *
+ * @param relay Relay created using teosockRelayCreate().
+ * @param source Socket to read data from, should be in non-blocking mode.
+ * @param destination Socket to write data to, should be in non-blocking mode.
+ * @param relayed_length [out] A null pointer, or points to a variable to store amount of forwarded bytes.
+ *
+ * @returns Result of operation.
+ */
+TEOBASE_API teosockRelayResult teosockRelayForward(
+    teosockRelay* relay,
+    teonetSocket source,
+    teonetSocket destination,
+    size_t* relayed_length);
+
+/**
+ * Gets amount of data read from source but not written to destination yet.
+ *
+ * @param relay Relay created using teosockRelayCreate().
+ *
+ * @returns Amount of pending bytes.
+ */
+TEOBASE_API size_t teosockRelayGetPendingLength(const teosockRelay* relay);
+
+/// Recommended minimal size of zero-copy send. Page pinning costs more than copying of smaller buffers.
+#define TEOSOCK_ZEROCOPY_DEFAULT_MIN_LENGTH 16384
+
+/// Zero-copy send state of a socket. Initialize it using teosockZerocopyInit(), do not modify fields directly.
+typedef struct teosockZerocopy {
+    teonetSocket socket_descriptor;  ///< Socket with zero-copy sends.
+    size_t min_length;  ///< Sends shorter than this are copied.
+    uint32_t next_id;  ///< Identifier the kernel assigns to next zero-copy send.
+    bool enabled;  ///< True if SO_ZEROCOPY was enabled on socket.
+} teosockZerocopy;
+
+/// Completion notification of zero-copy sends returned by teosockZerocopyDrain() function.
+typedef struct teosockZerocopyCompletion {
+    uint32_t first_id;  ///< Identifier of first completed send.
+    uint32_t last_id;  ///< Identifier of last completed send, inclusive.
+    bool copied;  ///< True if the kernel fell back to copying data for these sends.
+} teosockZerocopyCompletion;
+
+/**
+ * Enables zero-copy sends on a connected TCP socket.
+ *
+ * Uses SO_ZEROCOPY and MSG_ZEROCOPY on Linux. On other platforms or if
+ * the kernel does not support zero-copy, all sends are copied.
+ *
+ * @param zerocopy Zero-copy state to initialize.
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ * @param min_length Sends shorter than this are copied. See #TEOSOCK_ZEROCOPY_DEFAULT_MIN_LENGTH.
+ *
+ * @returns True if zero-copy sends were enabled, false if all sends will be copied.
+ */
+TEOBASE_API bool teosockZerocopyInit(
+    teosockZerocopy* zerocopy,
+    teonetSocket socket_descriptor,
+    size_t min_length);
+
+/**
+ * Sends data on a connected socket without copying it into the kernel if possible.
+ *
+ * If @p in_flight is set to true, the kernel keeps referencing @p data after return.
+ * The buffer must not be modified or freed until teosockZerocopyDrain() reports
+ * completion of send with @p send_id identifier.
+ *
+ * @param[in] zerocopy Zero-copy state initialized using teosockZerocopyInit().
+ * @param[in] data A pointer to the buffer with data.
+ * @param[in] length The length of data to be transmitted, in bytes.
+ * @param[out] in_flight Points to a variable in which true is stored if buffer is still referenced by the kernel.
+ * @param[out] send_id Points to a variable in which identifier of zero-copy send is stored.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of sent bytes otherwise.
+ *
+ * @note Amount of bytes sent can be less than the number requested to be sent
+ * in the @p length parameter.
+ */
+TEOBASE_API ssize_t teosockSendZerocopy(
+    teosockZerocopy* zerocopy,
+    const uint8_t* data,
+    size_t length,
+    bool* in_flight,
+    uint32_t* send_id);
+
+/**
+ * Reads zero-copy completion notifications from socket error queue. Never blocks.
+ *
+ * Each notification covers a range of send identifiers. Buffers of these
+ * sends can be reused. Error queue messages unrelated to zero-copy are discarded.
+ *
+ * @param zerocopy Zero-copy state initialized using teosockZerocopyInit().
+ * @param completions An array to store notifications.
+ * @param max_completions The number of elements in @p completions array.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of stored notifications otherwise.
+ *
+ * @note Transmit timestamps are discarded too, see teosockTxTimestampDrain().
+ */
+TEOBASE_API int teosockZerocopyDrain(
+    teosockZerocopy* zerocopy,
+    teosockZerocopyCompletion* completions,
+    size_t max_completions);
+
+/// Scatter-gather buffer descriptor. Layout matches struct iovec on Unix and WSABUF on Windows.
+#if defined(TEONET_OS_WINDOWS)
+typedef struct teosockIovec {
+    ULONG length;  ///< The length of buffer in bytes.
+    uint8_t* data;  ///< A pointer to the buffer.
+} teosockIovec;
+#else
+typedef struct teosockIovec {
+    uint8_t* data;  ///< A pointer to the buffer.
+    size_t length;  ///< The length of buffer in bytes.
+} teosockIovec;
+#endif
+
+/**
+ * Sends data gathered from several buffers on a connected socket.
+ *
+ * Uses writev() on Unix and WSASend() on Windows.
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ * @param iov An array of buffers with data.
+ * @param iov_count The number of buffers in @p iov array.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of sent bytes otherwise.
+ *
+ * @note Amount of bytes sent can be less than total length of buffers.
+ * Use teosockIovecAdvance() to skip sent data before sending the rest.
+ */
+TEOBASE_API ssize_t teosockSendv(
+    teonetSocket socket_descriptor,
+    const teosockIovec* iov,
+    size_t iov_count);
+
+/// Enumeration with bit flags for teosockSendvFlags() function.
+typedef enum teosockSendFlags {
+    /// More data follows, kernel may hold partially filled segment (MSG_MORE). Ignored where not supported.
+    TEOSOCK_SEND_MORE = 1 << 0,
+} teosockSendFlags;
+
+/**
+ * Sends data gathered from several buffers on a connected socket with send flags.
+ *
+ * Same as teosockSendv() but accepts a combination of teosockSendFlags.
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ * @param iov An array of buffers with data.
+ * @param iov_count The number of buffers in @p iov array.
+ * @param flags A combination of teosockSendFlags.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of sent bytes otherwise.
+ */
+TEOBASE_API ssize_t teosockSendvFlags(
+    teonetSocket socket_descriptor,
+    const teosockIovec* iov,
+    size_t iov_count,
+    int flags);
+
+/**
+ * Receives data from a connected socket scattering it into several buffers.
+ *
+ * Uses readv() on Unix and WSARecv() on Windows.
+ *
+ * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
+ * @param iov An array of buffers to store the data. Buffers are filled in order.
+ * @param iov_count The number of buffers in @p iov array.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of received bytes otherwise.
+ */
+TEOBASE_API ssize_t teosockRecvv(
+    teonetSocket socket_descriptor,
+    teosockIovec* iov,
+    size_t iov_count);
+
+/**
+ * Skips transferred bytes in an array of buffers after partial send or receive.
+ *
+ * Fully transferred buffers are skipped by moving @p iov pointer forward,
+ * partially transferred buffer is adjusted in place.
+ *
+ * @param[in,out] iov A pointer to the array of buffers.
+ * @param[in,out] iov_count A pointer to the number of buffers in array.
+ * @param[in] length The number of bytes that were transferred.
+ *
+ * @returns The number of buffers left to transfer.
+ */
+TEOBASE_API size_t teosockIovecAdvance(
+    teosockIovec** iov,
+    size_t* iov_count,
+    size_t length);
+
+/// Per-message status enumeration for teosockSendtoBatch() function.
+typedef enum teosockSendtoStatus {
+    TEOSOCK_SENDTO_SENT = 0,  ///< Message was sent. The number of sent bytes is stored in @a sent_length field.
+    TEOSOCK_SENDTO_TRY_AGAIN = 1,  ///< Recoverable error occurred, message was not sent. Error code is stored in @a error_code field.
+    TEOSOCK_SENDTO_FAILED = 2,  ///< Message was rejected. Error code is stored in @a error_code field.
+    TEOSOCK_SENDTO_NOT_SENT = 3,  ///< Message was not attempted because sending stopped on one of previous messages.
+} teosockSendtoStatus;
+
+/// Description of one datagram for teosockSendtoBatch() function.
+typedef struct teosockSendtoMessage {
+    const struct sockaddr* address;  ///< [in] Destination address, or a null pointer for a connected socket.
+    socklen_t address_length;  ///< [in] The length of a structure pointed to by @a address.
+    teosockIovec* iov;  ///< [in] An array of buffers forming the datagram.
+    size_t iov_count;  ///< [in] The number of buffers in @a iov array.
+    teosockSendtoStatus status;  ///< [out] Result of sending this message.
+    size_t sent_length;  ///< [out] The number of bytes sent if message was sent.
+    int error_code;  ///< [out] Error code if message was not sent.
+} teosockSendtoMessage;
+
+/**
+ * Sends several datagrams, possibly to different destinations, in one call.
+ *
+ * Uses sendmmsg() on Linux and falls back to a loop over sendmsg() or WSASendTo()
+ * on other platforms. Status of every message is stored in its @a status field.
+ * Messages rejected by the kernel (e.g. unreachable destination or too long datagram)
+ * are marked TEOSOCK_SENDTO_FAILED and sending continues with the next message.
+ * Sending stops on recoverable errors like full send buffer and on errors that
+ * make the socket unusable, remaining messages are marked TEOSOCK_SENDTO_NOT_SENT.
+ *
+ * @param[in] socket_descriptor Socket descriptor of a datagram socket.
+ * @param[in,out] messages An array of messages to send.
+ * @param[in] messages_count The number of messages in @a messages array.
+ *
+ * @returns The number of messages that were sent.
+ */
+TEOBASE_API size_t teosockSendtoBatch(
+    teonetSocket socket_descriptor,
+    teosockSendtoMessage* messages,
+    size_t messages_count);
+
+/// Enumeration with bit flags for UDP segmentation offload modes for teosockSetUdpOffload() function.
+typedef enum teosockUdpOffloadMode {
+    TEOSOCK_UDP_OFFLOAD_SEGMENT = 1 << 0,  ///< Send large buffers as one super-buffer split by kernel or NIC (UDP_SEGMENT).
+    TEOSOCK_UDP_OFFLOAD_GRO = 1 << 1,  ///< Receive several datagrams of the same flow coalesced into one buffer (UDP_GRO).
+} teosockUdpOffloadMode;
+
+/// Maximum number of datagrams the kernel accepts in one segmented send.
+#define TEOSOCK_UDP_MAX_SEGMENTS 64
+
+/**
+ * Enable UDP segmentation offload modes on a datagram socket.
+ *
+ * Offloads are supported only on Linux. On other platforms no mode is enabled,
+ * and teosockSendtoSegmented() and teosockRecvfromSegmented() work
+ * one datagram at a time.
+ *
+ * @param socket_descriptor Socket descriptor of a UDP socket.
+ * @param offload_mask A combination of teosockUdpOffloadMode flags defining modes to enable.
+ *
+ * @returns A combination of teosockUdpOffloadMode flags that were enabled.
+ */
+TEOBASE_API int teosockSetUdpOffload(teonetSocket socket_descriptor, int offload_mask);
+
+/**
+ * Sends a buffer as a train of datagrams of equal size.
+ *
+ * The buffer is split into datagrams of @p segment_size bytes, the last one may be shorter.
+ * On Linux up to #TEOSOCK_UDP_MAX_SEGMENTS datagrams are passed to the kernel
+ * as one super-buffer using UDP_SEGMENT. If segmentation offload is unavailable,
+ * datagrams are sent using teosockSendtoBatch().
+ *
+ * @param socket_descriptor Socket descriptor of a UDP socket.
+ * @param data A pointer to the buffer with data.
+ * @param length The length of data to be transmitted, in bytes.
+ * @param segment_size The size of each datagram in bytes.
+ * @param address Destination address, or a null pointer for a connected socket.
+ * @param address_length The length of a structure pointed to by @a address.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR if nothing was sent, amount of sent bytes otherwise.
+ *
+ * @note Amount of bytes sent can be less than @p length if socket send buffer
+ * became full. Sent amount always ends on a datagram boundary.
+ */
+TEOBASE_API ssize_t teosockSendtoSegmented(
+    teonetSocket socket_descriptor,
+    const uint8_t* data,
+    size_t length,
+    size_t segment_size,
+    const struct sockaddr* address,
+    socklen_t address_length);
+
+/**
+ * Receives data from a datagram socket that may contain several coalesced datagrams.
+ *
+ * Works like teosockRecvfrom(). If UDP_GRO is enabled on the socket, received buffer
+ * can contain several datagrams from the same sender. They all have
+ * @a segment_size bytes except the last one, which may be shorter.
+ * Use teosockSplitSegments() to get per-datagram views.
+ *
+ * @param[in] socket_descriptor Socket descriptor of a UDP socket.
+ * @param[in] buffer A pointer to the buffer to store the data. Should be 64 KiB long to fit coalesced datagrams.
+ * @param[in] buffer_size The length of buffer in bytes.
+ * @param[out] address A sockaddr structure in which the sending address is to be stored.
+ * @param[in,out] address_length The length of a structure pointed to by @a address argument.
+ * @param[out] received_length A null pointer, or points to a variable in which the length of received data in bytes is to be stored if data was received.
+ * @param[out] segment_size A null pointer, or points to a variable in which the size of coalesced datagrams is to be stored if data was received.
+ * @param[out] error_code A null pointer, or points to a variable in which the error code is to be stored.
+ *
+ * @returns Result of operation.
+ */
+TEOBASE_API teosockRecvfromResult teosockRecvfromSegmented(
+    teonetSocket socket_descriptor,
+    uint8_t* buffer,
+    size_t buffer_size,
+    struct sockaddr* __restrict address,
+    socklen_t* address_length,
+    size_t* received_length,
+    size_t* segment_size,
+    int* error_code);
+
+/**
+ * Splits buffer received by teosockRecvfromSegmented() into per-datagram views.
+ *
+ * @param buffer A pointer to the received data.
+ * @param received_length The length of received data in bytes.
+ * @param segment_size The size of coalesced datagrams in bytes.
+ * @param views An array to store datagram views. Views point into @p buffer.
+ * @param views_count The number of elements in @p views array.
+ *
+ * @returns The number of views stored in @p views array.
+ */
+TEOBASE_API size_t teosockSplitSegments(
+    uint8_t* buffer,
+    size_t received_length,
+    size_t segment_size,
+    teosockIovec* views,
+    size_t views_count);
+
 /// Enumeration with bit flags for status masks for teosockSelect function.
 typedef enum teosockSelectMode {
     TEOSOCK_SELECT_MODE_READ = 1 << 0,  ///< Check socket for readability.
@@ -195,18 +953,187 @@ typedef enum teosockSelectResult {
     TEOSOCK_SELECT_ERROR = -1,  ///< An error occurred.
 } teosockSelectResult;
 
+/// Enumeration with bit flags for teosockSetTimestamping() function.
+typedef enum teosockTimestampingFlags {
+    TEOSOCK_TIMESTAMPING_RX_SOFTWARE = 1 << 0,  ///< Timestamp received packets when they enter the kernel.
+    TEOSOCK_TIMESTAMPING_TX_SOFTWARE = 1 << 1,  ///< Timestamp sent packets when they leave the kernel.
+    TEOSOCK_TIMESTAMPING_RX_HARDWARE = 1 << 2,  ///< Timestamp received packets by network adapter.
+    TEOSOCK_TIMESTAMPING_TX_HARDWARE = 1 << 3,  ///< Timestamp sent packets by network adapter.
+} teosockTimestampingFlags;
+
+/// Kernel timestamp of a packet. Time is in nanoseconds since Unix Epoch, zero if not available.
+typedef struct teosockTimestamp {
+    int64_t software_ns;  ///< Timestamp taken by the kernel.
+    int64_t hardware_ns;  ///< Timestamp taken by network adapter.
+} teosockTimestamp;
+
+/// Point of transmit path where timestamp was taken, values match Linux SCM_TSTAMP_* constants.
+typedef enum teosockTxTimestampType {
+    TEOSOCK_TX_TIMESTAMP_SEND = 0,  ///< Packet was passed to network adapter.
+    TEOSOCK_TX_TIMESTAMP_SCHEDULE = 1,  ///< Packet entered packet scheduler.
+    TEOSOCK_TX_TIMESTAMP_ACK = 2,  ///< All data of TCP send was acknowledged by peer.
+} teosockTxTimestampType;
+
+/// Transmit timestamp returned by teosockTxTimestampDrain() function.
+typedef struct teosockTxTimestamp {
+    uint32_t id;  ///< Index of datagram counted from zero since timestamping was enabled, or byte offset of last byte for TCP.
+    teosockTxTimestampType type;  ///< Point of transmit path where timestamp was taken.
+    teosockTimestamp timestamp;  ///< Timestamp of the send.
+} teosockTxTimestamp;
+
+/**
+ * Enables kernel timestamping of received and sent packets.
+ *
+ * Uses SO_TIMESTAMPING on Linux and falls back to SO_TIMESTAMPNS if only software
+ * receive timestamps are requested. Software timestamps use the same clock as
+ * teotimeGetCurrentTimeUs(), so difference between them is the time packet spent
+ * in the kernel queue. Hardware timestamps also need to be enabled on network adapter.
+ *
+ * @param socket_descriptor Socket descriptor.
+ * @param timestamping_flags A combination of teosockTimestampingFlags, zero disables timestamping.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or is not supported by the platform.
+ */
+TEOBASE_API int teosockSetTimestamping(teonetSocket socket_descriptor, int timestamping_flags);
+
+/**
+ * Receives a datagram with its kernel receive timestamp.
+ *
+ * Same as teosockRecvfrom() but also returns timestamp enabled by teosockSetTimestamping().
+ *
+ * @param[in] socket_descriptor Socket descriptor.
+ * @param[in] buffer A pointer to the buffer to store the data.
+ * @param[in] buffer_size The length of buffer in bytes.
+ * @param[out] address A sockaddr structure in which the sending address is to be stored.
+ * @param[in,out] address_length The length of a structure pointed to by @a address argument.
+ * @param[out] received_length A null pointer, or points to a variable in which the length of received message in bytes is to be stored if data was received.
+ * @param[out] timestamp Receive timestamp, zero fields if timestamp is not available.
+ * @param[out] error_code A null pointer, or points to a variable in which the error code is to be stored.
+ *
+ * @returns Result of operation.
+ */
+TEOBASE_API teosockRecvfromResult teosockRecvfromTimestamped(
+    teonetSocket socket_descriptor,
+    uint8_t* buffer,
+    size_t buffer_size,
+    struct sockaddr* __restrict address,
+    socklen_t* address_length,
+    size_t* received_length,
+    teosockTimestamp* timestamp,
+    int* error_code);
+
+/**
+ * Reads transmit timestamps from socket error queue without blocking.
+ *
+ * @param socket_descriptor Socket descriptor with transmit timestamping enabled.
+ * @param timestamps An array to store timestamps.
+ * @param max_timestamps The number of elements in @p timestamps array.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of stored timestamps otherwise.
+ *
+ * @note Other error queue messages are discarded, so do not combine transmit
+ * timestamping with teosockZerocopyDrain() on the same socket.
+ */
+TEOBASE_API int teosockTxTimestampDrain(
+    teonetSocket socket_descriptor,
+    teosockTxTimestamp* timestamps,
+    size_t max_timestamps);
+
+/// Mask of Explicit Congestion Notification bits in type of service or traffic class.
+#define TEOSOCK_ECN_MASK 0x03
+
+/// Delivery information of a datagram returned by teosockRecvfromDatagramInfo() function.
+typedef struct teosockDatagramInfo {
+    struct sockaddr_storage local_address;  ///< Destination address of datagram, port is not set.
+    socklen_t local_address_length;  ///< The length of address stored in @a local_address, zero if not available.
+    unsigned int interface_index;  ///< Index of interface datagram was received on, zero if not available.
+    int ttl;  ///< TTL or hop limit of datagram, -1 if not available.
+    int ecn;  ///< ECN bits of datagram, -1 if not available.
+    bool truncated;  ///< Control data did not fit and was truncated by the kernel, some fields may be missing.
+} teosockDatagramInfo;
+
+/**
+ * Enables reception of datagram destination address, interface, TTL and traffic class.
+ *
+ * Sets IP_PKTINFO, IP_RECVTTL, IP_RECVTOS or their IPv6 counterparts depending on
+ * socket family. Call it after binding the socket.
+ *
+ * @param socket_descriptor Bound UDP socket descriptor.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed or is not supported by the platform.
+ */
+TEOBASE_API int teosockSetDatagramInfo(teonetSocket socket_descriptor);
+
+/**
+ * Receives a datagram with its destination address, interface, TTL and ECN bits.
+ *
+ * Same as teosockRecvfrom() but also returns information enabled by teosockSetDatagramInfo().
+ * One socket bound to wildcard address can serve all interfaces of multi-homed host
+ * and reply from the address request was sent to using teosockSendtoFrom().
+ *
+ * @param[in] socket_descriptor Socket descriptor.
+ * @param[in] buffer A pointer to the buffer to store the data.
+ * @param[in] buffer_size The length of buffer in bytes.
+ * @param[out] address A sockaddr structure in which the sending address is to be stored.
+ * @param[in,out] address_length The length of a structure pointed to by @a address argument.
+ * @param[out] received_length A null pointer, or points to a variable in which the length of received message in bytes is to be stored if data was received.
+ * @param[out] info Delivery information of datagram. Fields which are not available are marked as described in teosockDatagramInfo.
+ * @param[out] error_code A null pointer, or points to a variable in which the error code is to be stored.
+ *
+ * @returns Result of operation.
+ */
+TEOBASE_API teosockRecvfromResult teosockRecvfromDatagramInfo(
+    teonetSocket socket_descriptor,
+    uint8_t* buffer,
+    size_t buffer_size,
+    struct sockaddr* __restrict address,
+    socklen_t* address_length,
+    size_t* received_length,
+    teosockDatagramInfo* info,
+    int* error_code);
+
+/**
+ * Sends a datagram from specified local address.
+ *
+ * @param socket_descriptor Socket descriptor.
+ * @param data A pointer to the buffer with data.
+ * @param length The length of data in bytes.
+ * @param address Destination address.
+ * @param address_length The length of @p address.
+ * @param source Local address and interface to send from, usually received by teosockRecvfromDatagramInfo().
+ * Zero interface index lets routing choose interface. NULL sends like sendto().
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of sent bytes otherwise.
+ *
+ * @note Source address must be a unicast address of this host.
+ * Windows ignores @p source.
+ */
+TEOBASE_API ssize_t teosockSendtoFrom(
+    teonetSocket socket_descriptor,
+    const uint8_t* data,
+    size_t length,
+    const struct sockaddr* address,
+    socklen_t address_length,
+    const teosockDatagramInfo* source);
+
 /**
  * Determines the status of the socket, waiting if necessary, to perform synchronous operation.
  *
  * @param socket_descriptor Socket descriptor obtained using teosockCreateTcp() function.
  * @param status_mask A combination of teosockSelectMode flags defining modes to check.
- * @param timeout_ms The amount of time to wait before returning timeout, in milliseconds.
+ * @param timeout_ms The amount of time to wait before returning timeout, in milliseconds. Must not be negative.
  *
  * @returns Result of operation.
  *
  * @retval TEOSOCK_SELECT_READY if socket have data ready to be read.
  * @retval TEOSOCK_SELECT_TIMEOUT if no data was received before reaching timeout.
- * @retval TEOSOCK_SELECT_ERROR if an error occurred.
+ * @retval TEOSOCK_SELECT_ERROR if an error occurred, for example descriptor is invalid or timeout is negative.
  */
 TEOBASE_API teosockSelectResult teosockSelect(
     teonetSocket socket_descriptor,
@@ -291,6 +1218,105 @@ TEOBASE_API int teosockSetBlockingMode(
  */
 TEOBASE_API int teosockSetTcpNodelay(teonetSocket socket_descriptor);
 
+/// Value of teosockProfile field which leaves socket option unchanged.
+#define TEOSOCK_PROFILE_KEEP (-1)
+
+/// Socket tuning profile. Integer fields set to #TEOSOCK_PROFILE_KEEP are not applied.
+typedef struct teosockProfile {
+    const char* name;  ///< Profile name.
+    int receive_buffer_size;  ///< SO_RCVBUF value in bytes.
+    int send_buffer_size;  ///< SO_SNDBUF value in bytes.
+    bool force_buffer_size;  ///< Try SO_RCVBUFFORCE and SO_SNDBUFFORCE to exceed system limits, needs CAP_NET_ADMIN. Linux only.
+    int busy_poll_us;  ///< SO_BUSY_POLL value in microseconds, zero disables busy polling. Raising it needs CAP_NET_ADMIN. Ignored if kernel lacks support. Linux only.
+    int tcp_nodelay;  ///< TCP_NODELAY value, 1 or 0. TCP sockets only.
+    int tcp_quickack;  ///< TCP_QUICKACK value, 1 or 0. TCP sockets only, Linux only.
+    int tcp_notsent_lowat;  ///< TCP_NOTSENT_LOWAT value in bytes. TCP sockets only, Linux only.
+    int type_of_service;  ///< IP_TOS value, or IPV6_TCLASS for IPv6 sockets.
+} teosockProfile;
+
+/**
+ * Gets predefined socket tuning profile by name.
+ *
+ * Available profiles:
+ * - "low-latency": moderate buffers, busy polling if permitted, TCP_NODELAY, TCP_QUICKACK,
+ *   small TCP_NOTSENT_LOWAT and low delay type of service.
+ * - "bulk-throughput": large buffers, no busy polling, Nagle's algorithm enabled
+ *   and throughput type of service.
+ *
+ * @param name Profile name.
+ *
+ * @returns Pointer to profile or NULL if there is no profile with such name.
+ */
+TEOBASE_API const teosockProfile* teosockGetProfile(const char* name);
+
+/**
+ * Applies socket tuning profile and reads back effective values.
+ *
+ * All options are tried even if some of them fail. Options not supported by socket
+ * type or platform are skipped.
+ *
+ * @param socket_descriptor Socket descriptor.
+ * @param profile Profile to apply, obtained using teosockGetProfile() or filled by caller.
+ * @param effective [out] Effective values after applying profile, can be NULL.
+ * Options which can't be read are set to #TEOSOCK_PROFILE_KEEP.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if all options were applied.
+ * @retval TEOSOCK_SOCKET_ERROR if at least one option failed.
+ *
+ * @note Linux doubles buffer sizes to account for bookkeeping overhead and caps them
+ * by net.core.rmem_max and net.core.wmem_max, check @p effective values.
+ * @note Linux resets TCP_QUICKACK by itself, apply profile again to re-enable it.
+ * @note Raising SO_BUSY_POLL without CAP_NET_ADMIN is not treated as failure, the option
+ * keeps its previous value which is reported in @p effective. Neither is a kernel built without
+ * busy polling support, then @p effective reports TEOSOCK_PROFILE_KEEP.
+ */
+TEOBASE_API int teosockApplyProfile(
+    teonetSocket socket_descriptor,
+    const teosockProfile* profile,
+    teosockProfile* effective);
+
+/// Socket I/O statistics of a thread, collected when enabled by teosockStatsSetEnabled().
+typedef struct teosockStats {
+    uint64_t recv_calls;  ///< Calls of teosockRecv(), teosockRecvv(), teosockRecvfrom() and its variants. Batch receives count each datagram.
+    uint64_t recv_bytes;  ///< Bytes received by these calls.
+    uint64_t send_calls;  ///< Calls of teosockSend(), teosockSendv(), their variants and datagram sends. Batch and segmented sends count each datagram.
+    uint64_t send_bytes;  ///< Bytes sent by these calls.
+    uint64_t short_writes;  ///< Sends which transferred less than requested.
+    uint64_t would_block;  ///< Calls failed with EAGAIN or EWOULDBLOCK.
+    uint64_t fatal_errors;  ///< Calls failed with error which makes the socket unusable.
+    uint64_t other_errors;  ///< Calls failed with other errors.
+    uint64_t orderly_closes;  ///< Receives which returned zero bytes.
+    uint64_t select_calls;  ///< Calls of teosockSelect().
+    uint64_t select_timeouts;  ///< Calls of teosockSelect() which timed out.
+    uint64_t blocked_time_us;  ///< Time spent waiting in teosockSelect(), in microseconds.
+} teosockStats;
+
+/**
+ * Enables or disables collection of socket I/O statistics. Disabled by default.
+ *
+ * Statistics are counted per thread without synchronization,
+ * so enabled collection costs a few increments per call.
+ *
+ * @param enabled True to enable collection.
+ *
+ * @note Set once at startup, the flag itself is not synchronized.
+ */
+TEOBASE_API void teosockStatsSetEnabled(bool enabled);
+
+/**
+ * Gets socket I/O statistics of the calling thread.
+ *
+ * @param stats [out] Statistics collected since thread start or last teosockStatsReset() call.
+ */
+TEOBASE_API void teosockStatsGet(teosockStats* stats);
+
+/**
+ * Resets socket I/O statistics of the calling thread.
+ */
+TEOBASE_API void teosockStatsReset(void);
+
 /**
  * Initialize socket library.
  *
@@ -319,6 +1345,22 @@ TEOBASE_API int teosockInit(void);
  */
 TEOBASE_API int teosockCleanup(void);
 
+/**
+ * Gets error code of the last failed socket function.
+ *
+ * @returns errno value, or WSAGetLastError() value on Windows.
+ */
+TEOBASE_INTERNAL int teosockGetLastError(void);
+
+/**
+ * Checks if socket error code means that operation would block and can be retried later.
+ *
+ * @param error_code Error code returned by teosockGetLastError().
+ *
+ * @returns true for EAGAIN and EWOULDBLOCK, or WSAEWOULDBLOCK on Windows.
+ */
+TEOBASE_INTERNAL bool teosockRecvfromErrorIsRecoverable(int error_code);
+
 #ifdef __cplusplus
 }
 #endif
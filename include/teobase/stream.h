@@ -0,0 +1,163 @@
+/**
+ * @file teobase/stream.h
+ * @brief Buffered TCP stream with write coalescing.
+ *
+ * Small writes are collected in a ring buffer and sent together
+ * using one teosockSendv() call when the amount of queued data reaches
+ * flush threshold, on explicit flush or when the socket becomes writable.
+ * Reads fill a large buffer which is parsed in place.
+ */
+
+#pragma once
+
+#ifndef TEOBASE_STREAM_H
+#define TEOBASE_STREAM_H
+
+#include "teobase/types.h"
+
+#include "teobase/socket.h"
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Default size of stream write queue and read buffer in bytes.
+#define TEOSOCK_STREAM_DEFAULT_BUFFER_SIZE 65536
+
+/// Default amount of queued bytes which triggers sending.
+#define TEOSOCK_STREAM_DEFAULT_FLUSH_THRESHOLD 16384
+
+/// Opaque buffered stream. Create it using teosockStreamCreate().
+typedef struct teosockStream teosockStream;
+
+/// Result enumeration for stream functions.
+typedef enum teosockStreamResult {
+    TEOSOCK_STREAM_SUCCESS = 0,  ///< Operation completed.
+    TEOSOCK_STREAM_PENDING = 1,  ///< Socket would block. Wait for readability or writability and call again.
+    TEOSOCK_STREAM_BUFFER_FULL = 2,  ///< Not enough space in buffer. Nothing was written or read.
+    TEOSOCK_STREAM_CLOSED = 3,  ///< The connection was orderly shut down by peer.
+    TEOSOCK_STREAM_ERROR = -1,  ///< Socket error occurred. Error code is kept in errno or WSAGetLastError().
+} teosockStreamResult;
+
+/**
+ * Creates a buffered stream on a connected socket.
+ *
+ * @param socket_descriptor Connected TCP socket, preferably in non-blocking mode.
+ * @param write_buffer_size Size of write queue in bytes, the largest message that can be written.
+ * @param read_buffer_size Size of read buffer in bytes, the largest message that can be parsed.
+ * @param flush_threshold Amount of queued bytes which triggers sending.
+ *
+ * @returns Pointer to created stream or NULL on error.
+ *
+ * @note Stream does not own the socket, close it after destroying the stream.
+ */
+TEOBASE_API teosockStream* teosockStreamCreate(
+    teonetSocket socket_descriptor,
+    size_t write_buffer_size,
+    size_t read_buffer_size,
+    size_t flush_threshold);
+
+/**
+ * Destroys a stream. Queued data which was not flushed is lost.
+ *
+ * @param stream Stream created using teosockStreamCreate(). Can be NULL.
+ */
+TEOBASE_API void teosockStreamDestroy(teosockStream* stream);
+
+/**
+ * Enables corking of sends triggered by flush threshold.
+ *
+ * Data sent because of threshold is marked with MSG_MORE, so the kernel keeps
+ * the last partially filled segment. The last queued byte is held back, so
+ * teosockStreamFlush() sends it without MSG_MORE and pushes the segment.
+ * Supported only on Linux, does nothing elsewhere.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ * @param enabled True to enable corking.
+ */
+TEOBASE_API void teosockStreamSetCork(teosockStream* stream, bool enabled);
+
+/**
+ * Queues data for sending. Message is queued as a whole or not at all.
+ *
+ * If queued data reaches flush threshold, it is sent together with @p data
+ * in one system call, data which was not sent stays in queue.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ * @param data A pointer to the buffer with data.
+ * @param length The length of data in bytes.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_STREAM_SUCCESS if data was queued or sent.
+ * @retval TEOSOCK_STREAM_BUFFER_FULL if data does not fit into write queue. Wait for writability and flush.
+ * @retval TEOSOCK_STREAM_ERROR if socket error occurred.
+ */
+TEOBASE_API teosockStreamResult teosockStreamWrite(teosockStream* stream, const uint8_t* data, size_t length);
+
+/**
+ * Sends all queued data.
+ *
+ * Call it after writing a batch of messages and when socket becomes writable
+ * while teosockStreamGetPendingLength() is not zero.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_STREAM_SUCCESS if all queued data was sent.
+ * @retval TEOSOCK_STREAM_PENDING if some data is left in queue. Wait for writability and flush again.
+ * @retval TEOSOCK_STREAM_ERROR if socket error occurred.
+ */
+TEOBASE_API teosockStreamResult teosockStreamFlush(teosockStream* stream);
+
+/**
+ * Gets amount of queued data which was not sent yet.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ *
+ * @returns Amount of queued bytes.
+ */
+TEOBASE_API size_t teosockStreamGetPendingLength(const teosockStream* stream);
+
+/**
+ * Reads available data from socket into read buffer with one system call.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ * @param received_length [out] A null pointer, or points to a variable to store amount of received bytes.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_STREAM_SUCCESS if data was received.
+ * @retval TEOSOCK_STREAM_PENDING if no data is available. Wait for readability.
+ * @retval TEOSOCK_STREAM_BUFFER_FULL if read buffer is full. Consume data first.
+ * @retval TEOSOCK_STREAM_CLOSED if peer closed connection.
+ * @retval TEOSOCK_STREAM_ERROR if socket error occurred.
+ */
+TEOBASE_API teosockStreamResult teosockStreamFill(teosockStream* stream, size_t* received_length);
+
+/**
+ * Gets received data which was not consumed yet.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ * @param length [out] Amount of available bytes.
+ *
+ * @returns Pointer to contiguous received data, valid until next teosockStreamFill() call.
+ */
+TEOBASE_API const uint8_t* teosockStreamPeek(const teosockStream* stream, size_t* length);
+
+/**
+ * Marks received data as processed.
+ *
+ * @param stream Stream created using teosockStreamCreate().
+ * @param length Amount of bytes to consume, not more than returned by teosockStreamPeek().
+ */
+TEOBASE_API void teosockStreamConsume(teosockStream* stream, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -21,6 +21,9 @@ enum {
     MILLISECONDS_IN_SECOND = 1000,  ///< Amount of milliseconds in second.
     MICROSECONDS_IN_SECOND = 1000000,  ///< Amount of microseconds in second.
     MICROSECONDS_IN_MILLISECOND = 1000,  ///< Amount of microseconds in millisecond.
+    NANOSECONDS_IN_SECOND = 1000000000,  ///< Amount of nanoseconds in second.
+    NANOSECONDS_IN_MICROSECOND = 1000,  ///< Amount of nanoseconds in microsecond.
+    NANOSECONDS_IN_MILLISECOND = 1000000,  ///< Amount of nanoseconds in millisecond.
 };
 
 /**
@@ -66,6 +69,161 @@ TEOBASE_API int64_t teotimeGetTimePassedUs(int64_t time_value_us);
  */
 TEOBASE_API int64_t teotimeGetTimePassedMs(int64_t time_value_ms);
 
+/**
+ * Get monotonic time in nanoseconds.
+ *
+ * Monotonic time is not affected by changes of system time, use it to measure
+ * durations and to compute deadlines and timeouts. Uses CLOCK_MONOTONIC,
+ * which is read without system call through vDSO on Linux, and
+ * QueryPerformanceCounter() on Windows.
+ *
+ * @return Monotonic time in nanoseconds since unspecified starting point.
+ *
+ * @note Values are comparable only within one boot of the system.
+ */
+TEOBASE_API int64_t teotimeGetMonotonicNs(void);
+
+/**
+ * Get monotonic time in microseconds.
+ *
+ * @return Monotonic time in microseconds since unspecified starting point.
+ */
+TEOBASE_API int64_t teotimeGetMonotonicUs(void);
+
+/**
+ * Get monotonic time in milliseconds.
+ *
+ * @return Monotonic time in milliseconds since unspecified starting point.
+ */
+TEOBASE_API int64_t teotimeGetMonotonicMs(void);
+
+/// Source of cycle counter values returned by teotimeGetCycles().
+typedef enum teotimeCyclesSource {
+    TEOTIME_CYCLES_MONOTONIC = 0,  ///< Cycle counter is not reliable, monotonic time in nanoseconds is used.
+    TEOTIME_CYCLES_TSC = 1,  ///< Invariant time stamp counter of x86 processor.
+    TEOTIME_CYCLES_ARM_COUNTER = 2,  ///< Virtual counter of ARMv8 processor.
+} teotimeCyclesSource;
+
+/**
+ * Calibrates cycle counter against monotonic clock.
+ *
+ * Checks that processor counter runs at constant rate and is synchronized
+ * between cores, then measures its frequency for about 10 milliseconds.
+ * Called automatically on first use of cycle counter functions, call it at startup
+ * to keep calibration delay out of hot path. Calling it again does nothing.
+ */
+TEOBASE_API void teotimeCalibrateCycles(void);
+
+/**
+ * Get cycle counter value.
+ *
+ * Costs a few nanoseconds when processor counter is used. Use it to measure
+ * short intervals and convert difference using teotimeCyclesToNs().
+ * Falls back to teotimeGetMonotonicNs() when processor counter is not reliable.
+ *
+ * @return Cycle counter value since unspecified starting point.
+ *
+ * @note Instructions may be reordered around the read, use teotimeGetCyclesOrdered()
+ * to read the counter at the end of measured code.
+ */
+TEOBASE_API int64_t teotimeGetCycles(void);
+
+/**
+ * Get cycle counter value after all preceding instructions completed.
+ *
+ * Uses rdtscp instruction or a load fence on x86.
+ *
+ * @return Cycle counter value since unspecified starting point.
+ */
+TEOBASE_API int64_t teotimeGetCyclesOrdered(void);
+
+/**
+ * Get source of cycle counter values.
+ *
+ * @return Cycle counter source selected by calibration.
+ */
+TEOBASE_API teotimeCyclesSource teotimeGetCyclesSource(void);
+
+/**
+ * Get cycle counter frequency.
+ *
+ * @return Amount of cycles in second, #NANOSECONDS_IN_SECOND if counter falls back to monotonic time.
+ */
+TEOBASE_API int64_t teotimeGetCyclesFrequency(void);
+
+/**
+ * Convert amount of cycles to nanoseconds.
+ *
+ * @param cycles Difference between two teotimeGetCycles() values.
+ *
+ * @return Time in nanoseconds.
+ */
+TEOBASE_API int64_t teotimeCyclesToNs(int64_t cycles);
+
+/**
+ * Convert amount of cycles to microseconds.
+ *
+ * @param cycles Difference between two teotimeGetCycles() values.
+ *
+ * @return Time in microseconds.
+ */
+TEOBASE_API int64_t teotimeCyclesToUs(int64_t cycles);
+
+/**
+ * Convert nanoseconds to amount of cycles.
+ *
+ * @param time_ns Time in nanoseconds.
+ *
+ * @return Amount of cycles, for example to compute deadline in cycles.
+ */
+TEOBASE_API int64_t teotimeNsToCycles(int64_t time_ns);
+
+/// Clock used by teotimeRefreshCachedTime() function.
+typedef enum teotimeCachedTimeSource {
+    TEOTIME_CACHED_MONOTONIC = 0,  ///< teotimeGetMonotonicNs(), precise.
+    TEOTIME_CACHED_MONOTONIC_COARSE = 1,  ///< CLOCK_MONOTONIC_COARSE, cheaper with resolution of scheduler tick. Linux only, precise clock is used elsewhere.
+} teotimeCachedTimeSource;
+
+/**
+ * Selects clock used to refresh cached time of the calling thread.
+ *
+ * @param source Clock to use. Default is #TEOTIME_CACHED_MONOTONIC.
+ */
+TEOBASE_API void teotimeSetCachedTimeSource(teotimeCachedTimeSource source);
+
+/**
+ * Reads clock and stores the result as cached time of the calling thread.
+ *
+ * Cached time is refreshed by teosockPollerWait(). Event loops which wait
+ * by other means should call this function once per iteration.
+ *
+ * @return New cached monotonic time in nanoseconds.
+ */
+TEOBASE_API int64_t teotimeRefreshCachedTime(void);
+
+/**
+ * Get cached monotonic time of the calling thread in nanoseconds.
+ *
+ * Costs one memory load. Time is refreshed on first use in thread.
+ *
+ * @return Monotonic time in nanoseconds at the moment of last refresh.
+ */
+TEOBASE_API int64_t teotimeGetCachedTimeNs(void);
+
+/**
+ * Get cached monotonic time of the calling thread in microseconds.
+ *
+ * @return Monotonic time in microseconds at the moment of last refresh.
+ */
+TEOBASE_API int64_t teotimeGetCachedTimeUs(void);
+
+/**
+ * Get cached monotonic time of the calling thread in milliseconds.
+ *
+ * @return Monotonic time in milliseconds at the moment of last refresh.
+ */
+TEOBASE_API int64_t teotimeGetCachedTimeMs(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,138 @@
+/**
+ * @file teobase/timer.h
+ * @brief Hierarchical timing wheel for large amounts of timers.
+ *
+ * Timers are sorted into slots by expiration tick. The first level has
+ * a slot per tick, every next level has slots 64 times wider which are
+ * moved to lower levels when their time comes. Starting, cancelling and
+ * expiring a timer takes constant time regardless of amount of timers.
+ * Timer structures are embedded into user objects, the wheel does not allocate memory.
+ * Time is taken from teotimeGetMonotonicMs().
+ */
+
+#pragma once
+
+#ifndef TEOBASE_TIMER_H
+#define TEOBASE_TIMER_H
+
+#include "teobase/types.h"
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Opaque timing wheel. Create it using teotimerWheelCreate().
+typedef struct teotimerWheel teotimerWheel;
+
+struct teotimer;
+
+/**
+ * Function called when timer expires.
+ *
+ * @param wheel Wheel the timer belonged to. Timer can be started again from the callback.
+ * @param timer Expired timer, it is not pending anymore.
+ * @param user_data User data passed to teotimerInit().
+ */
+typedef void (*teotimerCallback)(teotimerWheel* wheel, struct teotimer* timer, void* user_data);
+
+/// Timer. Initialize it using teotimerInit(), do not modify fields directly.
+typedef struct teotimer {
+    struct teotimer* next;  ///< Next timer in slot.
+    struct teotimer** pprev;  ///< Link pointing to this timer, NULL if timer is not pending.
+    int64_t expires_tick;  ///< Expiration time in wheel ticks.
+    teotimerCallback callback;  ///< Function called on expiration.
+    void* user_data;  ///< User data passed to callback.
+} teotimer;
+
+/**
+ * Creates a timing wheel.
+ *
+ * @param tick_ms Resolution of wheel in milliseconds. Timers expire on tick boundaries, never earlier than requested.
+ *
+ * @returns Pointer to created wheel or NULL on error.
+ *
+ * @note Wheel is not thread-safe, use it from one thread, for example in the thread of event loop.
+ */
+TEOBASE_API teotimerWheel* teotimerWheelCreate(int64_t tick_ms);
+
+/**
+ * Destroys a timing wheel. Pending timers are dropped without calling their callbacks.
+ *
+ * @param wheel Wheel created using teotimerWheelCreate(). Can be NULL.
+ */
+TEOBASE_API void teotimerWheelDestroy(teotimerWheel* wheel);
+
+/**
+ * Initializes a timer.
+ *
+ * @param timer Timer to initialize.
+ * @param callback Function called when timer expires.
+ * @param user_data User data passed to callback.
+ */
+TEOBASE_API void teotimerInit(teotimer* timer, teotimerCallback callback, void* user_data);
+
+/**
+ * Starts a timer. Pending timer is restarted with new delay.
+ *
+ * @param wheel Wheel created using teotimerWheelCreate().
+ * @param timer Timer initialized using teotimerInit().
+ * @param delay_ms Delay in milliseconds. Zero or negative delay expires timer on next processing.
+ */
+TEOBASE_API void teotimerStart(teotimerWheel* wheel, teotimer* timer, int64_t delay_ms);
+
+/**
+ * Cancels a timer.
+ *
+ * @param wheel Wheel the timer was started on.
+ * @param timer Timer initialized using teotimerInit().
+ *
+ * @returns true if timer was pending, false otherwise.
+ */
+TEOBASE_API bool teotimerCancel(teotimerWheel* wheel, teotimer* timer);
+
+/**
+ * Checks if timer is started and did not expire yet.
+ *
+ * @param timer Timer initialized using teotimerInit().
+ *
+ * @returns true if timer is pending.
+ */
+TEOBASE_API bool teotimerIsPending(const teotimer* timer);
+
+/**
+ * Calls callbacks of all expired timers.
+ *
+ * @param wheel Wheel created using teotimerWheelCreate().
+ *
+ * @returns The number of expired timers.
+ */
+TEOBASE_API size_t teotimerWheelProcess(teotimerWheel* wheel);
+
+/**
+ * Gets time until the next timer expires, suitable as timeout of teosockPollerWait().
+ *
+ * Timers far in the future are reported by time when their slot moves to lower level,
+ * so the wait may end before any timer expires. Call teotimerWheelProcess() and ask again.
+ *
+ * @param wheel Wheel created using teotimerWheelCreate().
+ *
+ * @returns Time in milliseconds, zero if there are expired timers, -1 if there are no pending timers.
+ */
+TEOBASE_API int teotimerWheelGetTimeout(teotimerWheel* wheel);
+
+/**
+ * Gets amount of pending timers.
+ *
+ * @param wheel Wheel created using teotimerWheelCreate().
+ *
+ * @returns The number of pending timers.
+ */
+TEOBASE_API size_t teotimerWheelGetCount(const teotimerWheel* wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
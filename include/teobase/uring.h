@@ -0,0 +1,266 @@
+/**
+ * @file teobase/uring.h
+ * @brief Asynchronous socket operations backed by Linux io_uring.
+ *
+ * This module is built only when configured with --enable-io-uring.
+ * Operations are queued using teosock*Async() functions, passed to the kernel
+ * in batches by teosockUringSubmit() and their results are collected
+ * in batches by teosockUringReap().
+ */
+
+#pragma once
+
+#ifndef TEOBASE_URING_H
+#define TEOBASE_URING_H
+
+#include "teobase/types.h"
+
+#include "teobase/socket.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "teobase/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Opaque io_uring instance. Create it using teosockUringCreate().
+typedef struct teosockUring teosockUring;
+
+/// Enumeration with bit flags for asynchronous operations.
+typedef enum teosockUringFlags {
+    /// Socket argument is an index in array registered using teosockUringRegisterSockets().
+    TEOSOCK_URING_FIXED_SOCKET = 1 << 0,
+} teosockUringFlags;
+
+/// Result of completed asynchronous operation.
+typedef struct teosockUringCompletion {
+    uint64_t user_data;  ///< Value passed when operation was queued.
+    int32_t result;  ///< Amount of transferred bytes, or negative errno value on error.
+} teosockUringCompletion;
+
+/// Storage for teosockRecvfromAsync() operation. Must stay valid until operation is completed.
+typedef struct teosockUringRecvfromRequest {
+    struct msghdr header;  ///< Message header passed to the kernel.
+    struct iovec vector;  ///< Buffer descriptor passed to the kernel.
+    struct sockaddr_storage address;  ///< Address of the datagram sender after completion.
+} teosockUringRecvfromRequest;
+
+/**
+ * Creates an io_uring instance.
+ *
+ * @param entries The number of submission queue entries, rounded up to a power of two.
+ *
+ * @returns Pointer to created instance or NULL on error.
+ *
+ * @note Instance is not thread-safe, queue and reap operations from one thread.
+ */
+TEOBASE_API teosockUring* teosockUringCreate(unsigned int entries);
+
+/**
+ * Destroys an io_uring instance. Operations in flight are cancelled by the kernel.
+ *
+ * @param uring Instance created using teosockUringCreate(). Can be NULL.
+ */
+TEOBASE_API void teosockUringDestroy(teosockUring* uring);
+
+/**
+ * Registers buffers to use with teosockRecvFixedAsync() and teosockSendFixedAsync().
+ *
+ * Registered buffers are pinned in memory once, which saves page mapping on every operation.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param buffers An array of buffers to register.
+ * @param buffers_count The number of buffers in @p buffers array.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed.
+ */
+TEOBASE_API int teosockUringRegisterBuffers(
+    teosockUring* uring,
+    const teosockIovec* buffers,
+    unsigned int buffers_count);
+
+/**
+ * Registers sockets to use with #TEOSOCK_URING_FIXED_SOCKET flag.
+ *
+ * Registered sockets save descriptor lookup and reference counting on every operation.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param sockets An array of sockets to register.
+ * @param sockets_count The number of sockets in @p sockets array.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation completed successfully.
+ * @retval TEOSOCK_SOCKET_ERROR if operation failed.
+ */
+TEOBASE_API int teosockUringRegisterSockets(
+    teosockUring* uring,
+    const teonetSocket* sockets,
+    unsigned int sockets_count);
+
+/**
+ * Queues receiving data from a connected socket. Asynchronous variant of teosockRecv().
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param socket_descriptor Socket descriptor, or registered socket index.
+ * @param data A pointer to the buffer to store the data. Must stay valid until completion.
+ * @param length The length of buffer in bytes. Lengths above UINT32_MAX are clamped to UINT32_MAX.
+ * @param flags A combination of teosockUringFlags.
+ * @param user_data Value to return in completion of this operation.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation was queued.
+ * @retval TEOSOCK_SOCKET_ERROR if submission queue is full. Submit queued operations and retry.
+ */
+TEOBASE_API int teosockRecvAsync(
+    teosockUring* uring,
+    teonetSocket socket_descriptor,
+    uint8_t* data,
+    size_t length,
+    int flags,
+    uint64_t user_data);
+
+/**
+ * Queues sending data on a connected socket. Asynchronous variant of teosockSend().
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param socket_descriptor Socket descriptor, or registered socket index.
+ * @param data A pointer to the buffer with data. Must stay valid until completion.
+ * @param length The length of data to be transmitted, in bytes. Lengths above UINT32_MAX are clamped,
+ * completion then reports a partial send.
+ * @param flags A combination of teosockUringFlags.
+ * @param user_data Value to return in completion of this operation.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation was queued.
+ * @retval TEOSOCK_SOCKET_ERROR if submission queue is full. Submit queued operations and retry.
+ */
+TEOBASE_API int teosockSendAsync(
+    teosockUring* uring,
+    teonetSocket socket_descriptor,
+    const uint8_t* data,
+    size_t length,
+    int flags,
+    uint64_t user_data);
+
+/**
+ * Queues receiving a datagram. Asynchronous variant of teosockRecvfrom().
+ *
+ * After completion sender address is stored in @a address field of @p request
+ * and its length in @a header.msg_namelen field.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param socket_descriptor Socket descriptor, or registered socket index.
+ * @param request Storage for operation. Must stay valid until completion.
+ * @param buffer A pointer to the buffer to store the data. Must stay valid until completion.
+ * @param buffer_size The length of buffer in bytes.
+ * @param flags A combination of teosockUringFlags.
+ * @param user_data Value to return in completion of this operation.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation was queued.
+ * @retval TEOSOCK_SOCKET_ERROR if submission queue is full. Submit queued operations and retry.
+ */
+TEOBASE_API int teosockRecvfromAsync(
+    teosockUring* uring,
+    teonetSocket socket_descriptor,
+    teosockUringRecvfromRequest* request,
+    uint8_t* buffer,
+    size_t buffer_size,
+    int flags,
+    uint64_t user_data);
+
+/**
+ * Queues receiving data into a registered buffer.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param socket_descriptor Socket descriptor, or registered socket index.
+ * @param buffer_index Index of buffer registered using teosockUringRegisterBuffers().
+ * @param data A pointer inside of registered buffer to store the data.
+ * @param length The length of data to receive in bytes. Must fit into registered buffer.
+ * Lengths above UINT32_MAX are clamped to UINT32_MAX.
+ * @param flags A combination of teosockUringFlags.
+ * @param user_data Value to return in completion of this operation.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation was queued.
+ * @retval TEOSOCK_SOCKET_ERROR if submission queue is full. Submit queued operations and retry.
+ */
+TEOBASE_API int teosockRecvFixedAsync(
+    teosockUring* uring,
+    teonetSocket socket_descriptor,
+    unsigned int buffer_index,
+    uint8_t* data,
+    size_t length,
+    int flags,
+    uint64_t user_data);
+
+/**
+ * Queues sending data from a registered buffer.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param socket_descriptor Socket descriptor, or registered socket index.
+ * @param buffer_index Index of buffer registered using teosockUringRegisterBuffers().
+ * @param data A pointer inside of registered buffer with data.
+ * @param length The length of data to be transmitted, in bytes. Must fit into registered buffer.
+ * Lengths above UINT32_MAX are clamped, completion then reports a partial send.
+ * @param flags A combination of teosockUringFlags.
+ * @param user_data Value to return in completion of this operation.
+ *
+ * @returns Result of operation.
+ *
+ * @retval TEOSOCK_SOCKET_SUCCESS if operation was queued.
+ * @retval TEOSOCK_SOCKET_ERROR if submission queue is full. Submit queued operations and retry.
+ */
+TEOBASE_API int teosockSendFixedAsync(
+    teosockUring* uring,
+    teonetSocket socket_descriptor,
+    unsigned int buffer_index,
+    const uint8_t* data,
+    size_t length,
+    int flags,
+    uint64_t user_data);
+
+/**
+ * Passes all queued operations to the kernel in one system call.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of submitted operations otherwise.
+ */
+TEOBASE_API int teosockUringSubmit(teosockUring* uring);
+
+/**
+ * Collects results of completed operations.
+ *
+ * Queued operations are submitted first. If less than @p min_completions
+ * operations are completed, waits for them in the same system call.
+ *
+ * @param uring Instance created using teosockUringCreate().
+ * @param completions An array to store completion results.
+ * @param max_completions The number of elements in @p completions array.
+ * @param min_completions The number of completions to wait for, zero to return immediately.
+ *
+ * @returns TEOSOCK_SOCKET_ERROR on error, amount of stored completions otherwise.
+ */
+TEOBASE_API int teosockUringReap(
+    teosockUring* uring,
+    teosockUringCompletion* completions,
+    unsigned int max_completions,
+    unsigned int min_completions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file bench/recvfrom_batch.c
+ * @brief Loopback benchmark of teosockRecvfromBatch() against teosockRecvfrom().
+ *
+ * Datagrams are queued on a loopback socket in rounds small enough to fit
+ * default receive buffer, then drained with non-blocking receive calls.
+ * Only draining time is measured.
+ *
+ * Usage: teobase-bench-recvfrom-batch [datagrams_count] [datagram_size]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if !defined(TEONET_OS_WINDOWS)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#include "teobase/socket.h"
+#include "teobase/time.h"
+
+// Datagrams queued before each drain, fits default loopback receive buffer.
+#define BENCH_ROUND_SIZE 128
+
+// Slots of one teosockRecvfromBatch() call.
+#define BENCH_BATCH_SIZE 64
+
+// Size of each receive buffer.
+#define BENCH_BUFFER_SIZE 2048
+
+static uint8_t bench_buffers[BENCH_BATCH_SIZE][BENCH_BUFFER_SIZE];
+
+// Queue a round of datagrams. Returns amount of datagrams sent.
+static size_t benchSendRound(teonetSocket sender, const struct sockaddr_in* address, size_t datagram_size) {
+    static const uint8_t payload[BENCH_BUFFER_SIZE];
+    size_t sent_count = 0;
+
+    for (size_t i = 0; i < BENCH_ROUND_SIZE; ++i) {
+        if (sendto(sender, (const char*)payload, (int)datagram_size, 0, (const struct sockaddr*)address,
+                sizeof(*address)) == (ssize_t)datagram_size) {
+            ++sent_count;
+        }
+    }
+
+    return sent_count;
+}
+
+// Drain receiver with teosockRecvfrom(). Returns amount of received datagrams.
+static size_t benchDrainSingle(teonetSocket receiver) {
+    size_t received_total = 0;
+
+    for (;;) {
+        struct sockaddr_storage address;
+        socklen_t address_length = sizeof(address);
+        size_t received_length = 0;
+
+        teosockRecvfromResult result = teosockRecvfrom(receiver, bench_buffers[0], BENCH_BUFFER_SIZE,
+            (struct sockaddr*)&address, &address_length, &received_length, NULL);
+        if (result != TEOSOCK_RECVFROM_DATA_RECEIVED) {
+            return received_total;
+        }
+
+        ++received_total;
+    }
+}
+
+// Drain receiver with teosockRecvfromBatch(). Returns amount of received datagrams.
+static size_t benchDrainBatch(teonetSocket receiver, teosockRecvfromMessage* messages) {
+    size_t received_total = 0;
+
+    for (;;) {
+        size_t received_count = 0;
+
+        teosockRecvfromResult result =
+            teosockRecvfromBatch(receiver, messages, BENCH_BATCH_SIZE, &received_count, NULL);
+        if (result != TEOSOCK_RECVFROM_DATA_RECEIVED) {
+            return received_total;
+        }
+
+        received_total += received_count;
+    }
+}
+
+// Run one pass and print receive rate.
+static void benchRun(teonetSocket sender, teonetSocket receiver, const struct sockaddr_in* address,
+    size_t datagrams_count, size_t datagram_size, bool batch) {
+    teosockRecvfromMessage messages[BENCH_BATCH_SIZE];
+    for (size_t i = 0; i < BENCH_BATCH_SIZE; ++i) {
+        messages[i].buffer = bench_buffers[i];
+        messages[i].buffer_size = BENCH_BUFFER_SIZE;
+    }
+
+    size_t received_total = 0;
+    int64_t elapsed_ns = 0;
+
+    while (received_total < datagrams_count) {
+        if (benchSendRound(sender, address, datagram_size) == 0) {
+            break;
+        }
+
+        int64_t start_ns = teotimeGetMonotonicNs();
+        received_total += batch ? benchDrainBatch(receiver, messages) : benchDrainSingle(receiver);
+        elapsed_ns += teotimeGetMonotonicNs() - start_ns;
+    }
+
+    double rate = elapsed_ns > 0 ? (double)received_total * 1e9 / (double)elapsed_ns : 0.0;
+    printf("%-22s %10zu datagrams %12.3f ms %12.0f datagrams/s\n", batch ? "teosockRecvfromBatch" : "teosockRecvfrom",
+        received_total, (double)elapsed_ns / 1e6, rate);
+}
+
+int main(int argc, char** argv) {
+    size_t datagrams_count = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 1000000;
+    size_t datagram_size = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 64;
+
+    if (datagram_size == 0 || datagram_size > BENCH_BUFFER_SIZE) {
+        fprintf(stderr, "Datagram size must be from 1 to %d bytes.\n", BENCH_BUFFER_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    teosockInit();
+
+    teonetSocket receiver = teosockCreateUdp();
+    teonetSocket sender = teosockCreateUdp();
+    if (receiver == TEOSOCK_INVALID_SOCKET || sender == TEOSOCK_INVALID_SOCKET) {
+        fprintf(stderr, "Failed to create sockets.\n");
+        return EXIT_FAILURE;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_length = sizeof(address);
+
+    if (bind(receiver, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        getsockname(receiver, (struct sockaddr*)&address, &address_length) != 0 ||
+        teosockSetBlockingMode(receiver, TEOSOCK_NON_BLOCKING_MODE) != TEOSOCK_SOCKET_SUCCESS) {
+        fprintf(stderr, "Failed to bind receiving socket.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Alternate passes so that both calls see similar cache and scheduler state.
+    for (int pass = 0; pass < 4; ++pass) {
+        benchRun(sender, receiver, &address, datagrams_count, datagram_size, (pass % 2) != 0);
+    }
+
+    teosockClose(sender);
+    teosockClose(receiver);
+    teosockCleanup();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,482 @@
+#include "teobase/histogram.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if defined(TEONET_OS_WINDOWS)
+#include "teobase/windows.h"
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TEOHISTOGRAM_ATOMIC_ADD(value, addend) InterlockedExchangeAdd64((volatile LONG64*)(value), (addend))
+#define TEOHISTOGRAM_ATOMIC_LOAD(value) (*(value))
+#define TEOHISTOGRAM_ATOMIC_STORE(value, new_value) InterlockedExchange64((volatile LONG64*)(value), (new_value))
+#define TEOHISTOGRAM_ATOMIC_REPLACE(value, expected, new_value) \
+    (InterlockedCompareExchange64((volatile LONG64*)(value), (new_value), (expected)) == (expected))
+#else
+#define TEOHISTOGRAM_ATOMIC_ADD(value, addend) __atomic_fetch_add((value), (addend), __ATOMIC_RELAXED)
+#define TEOHISTOGRAM_ATOMIC_LOAD(value) __atomic_load_n((value), __ATOMIC_RELAXED)
+#define TEOHISTOGRAM_ATOMIC_STORE(value, new_value) __atomic_store_n((value), (new_value), __ATOMIC_RELAXED)
+#define TEOHISTOGRAM_ATOMIC_REPLACE(value, expected, new_value) \
+    __sync_bool_compare_and_swap((value), (expected), (new_value))
+#endif
+
+// Serialized form starts with magic bytes and version.
+#define TEOHISTOGRAM_MAGIC "TEOH"
+#define TEOHISTOGRAM_MAGIC_LENGTH 4
+#define TEOHISTOGRAM_VERSION 1
+
+// Maximum length of 64-bit variable length integer.
+#define TEOHISTOGRAM_VARINT_MAX_LENGTH 10
+
+// Serialized form ends with total count of values, used to detect truncated data.
+#define TEOHISTOGRAM_TRAILER_LENGTH 8
+
+struct teohistogram {
+    int precision_bits;
+    int64_t max_value;
+    size_t buckets_count;
+
+    volatile int64_t min_recorded;
+    volatile int64_t max_recorded;
+
+    volatile int64_t counts[];
+};
+
+// Get index of the highest set bit, value must not be zero.
+static int teohistogramHighestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+// Get bucket index of value.
+// Values below 2^precision_bits have own buckets, each next power of two range
+// is split into 2^precision_bits buckets.
+static size_t teohistogramGetIndex(int precision_bits, int64_t value) {
+    uint64_t unsigned_value = (uint64_t)value;
+
+    if (unsigned_value < (UINT64_C(1) << precision_bits)) {
+        return (size_t)unsigned_value;
+    }
+
+    int highest_bit = teohistogramHighestBit(unsigned_value);
+    size_t group = (size_t)(highest_bit - precision_bits + 1);
+    size_t sub_bucket = (size_t)(unsigned_value >> (highest_bit - precision_bits)) - ((size_t)1 << precision_bits);
+
+    return (group << precision_bits) + sub_bucket;
+}
+
+// Get the lowest value counted in bucket.
+static int64_t teohistogramGetLowestValue(int precision_bits, size_t index) {
+    size_t group = index >> precision_bits;
+
+    if (group == 0) {
+        return (int64_t)index;
+    }
+
+    uint64_t sub_bucket = (uint64_t)(index & (((size_t)1 << precision_bits) - 1));
+
+    return (int64_t)(((UINT64_C(1) << precision_bits) + sub_bucket) << (group - 1));
+}
+
+// Get the highest value counted in bucket.
+static int64_t teohistogramGetHighestValue(int precision_bits, size_t index) {
+    size_t group = index >> precision_bits;
+    int64_t width = group == 0 ? 1 : (int64_t)(UINT64_C(1) << (group - 1));
+
+    return teohistogramGetLowestValue(precision_bits, index) + (width - 1);
+}
+
+// Clamp value to range of histogram.
+static int64_t teohistogramClamp(const teohistogram* histogram, int64_t value) {
+    if (value < 0) {
+        return 0;
+    }
+
+    return value > histogram->max_value ? histogram->max_value : value;
+}
+
+// Lower minimum and raise maximum if value is outside of them.
+static void teohistogramUpdateRange(teohistogram* histogram, int64_t value) {
+    int64_t min_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->min_recorded);
+    while (value < min_recorded && !TEOHISTOGRAM_ATOMIC_REPLACE(&histogram->min_recorded, min_recorded, value)) {
+        min_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->min_recorded);
+    }
+
+    int64_t max_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->max_recorded);
+    while (value > max_recorded && !TEOHISTOGRAM_ATOMIC_REPLACE(&histogram->max_recorded, max_recorded, value)) {
+        max_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->max_recorded);
+    }
+}
+
+// Creates a histogram.
+teohistogram* teohistogramCreate(int64_t max_value, int precision_bits) {
+    if (max_value < 1 || precision_bits < 1 || precision_bits > TEOHISTOGRAM_MAX_PRECISION_BITS) {
+        return NULL;
+    }
+
+    size_t buckets_count = teohistogramGetIndex(precision_bits, max_value) + 1;
+
+    teohistogram* histogram = calloc(1, sizeof(teohistogram) + buckets_count * sizeof(int64_t));
+    if (histogram == NULL) {
+        return NULL;
+    }
+
+    histogram->precision_bits = precision_bits;
+    histogram->max_value = max_value;
+    histogram->buckets_count = buckets_count;
+    histogram->min_recorded = INT64_MAX;
+    histogram->max_recorded = 0;
+
+    return histogram;
+}
+
+// Destroys a histogram.
+void teohistogramDestroy(teohistogram* histogram) {
+    free(histogram);
+}
+
+// Records a value.
+void teohistogramRecord(teohistogram* histogram, int64_t value) {
+    teohistogramRecordCount(histogram, value, 1);
+}
+
+// Records a value several times.
+void teohistogramRecordCount(teohistogram* histogram, int64_t value, int64_t count) {
+    if (count <= 0) {
+        return;
+    }
+
+    value = teohistogramClamp(histogram, value);
+
+    size_t index = teohistogramGetIndex(histogram->precision_bits, value);
+    TEOHISTOGRAM_ATOMIC_ADD(&histogram->counts[index], count);
+
+    teohistogramUpdateRange(histogram, value);
+}
+
+// Clears all recorded values.
+void teohistogramReset(teohistogram* histogram) {
+    for (size_t i = 0; i < histogram->buckets_count; ++i) {
+        TEOHISTOGRAM_ATOMIC_STORE(&histogram->counts[i], 0);
+    }
+
+    TEOHISTOGRAM_ATOMIC_STORE(&histogram->min_recorded, INT64_MAX);
+    TEOHISTOGRAM_ATOMIC_STORE(&histogram->max_recorded, 0);
+}
+
+// Adds values recorded in one histogram to another.
+bool teohistogramMerge(teohistogram* destination, const teohistogram* source) {
+    if (destination->precision_bits != source->precision_bits) {
+        return false;
+    }
+
+    bool has_values = false;
+
+    for (size_t i = 0; i < source->buckets_count; ++i) {
+        int64_t count = TEOHISTOGRAM_ATOMIC_LOAD(&source->counts[i]);
+        if (count == 0) {
+            continue;
+        }
+
+        size_t index = i < destination->buckets_count ? i : destination->buckets_count - 1;
+        TEOHISTOGRAM_ATOMIC_ADD(&destination->counts[index], count);
+        has_values = true;
+    }
+
+    int64_t min_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&source->min_recorded);
+    int64_t max_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&source->max_recorded);
+
+    // Range of source may be not updated yet or reset concurrently, keep range of destination then.
+    if (has_values && min_recorded != INT64_MAX) {
+        teohistogramUpdateRange(destination, teohistogramClamp(destination, min_recorded));
+        teohistogramUpdateRange(destination, teohistogramClamp(destination, max_recorded));
+    }
+
+    return true;
+}
+
+// Gets amount of recorded values.
+int64_t teohistogramGetCount(const teohistogram* histogram) {
+    int64_t total_count = 0;
+
+    for (size_t i = 0; i < histogram->buckets_count; ++i) {
+        total_count += TEOHISTOGRAM_ATOMIC_LOAD(&histogram->counts[i]);
+    }
+
+    return total_count;
+}
+
+// Gets the smallest recorded value.
+int64_t teohistogramGetMin(const teohistogram* histogram) {
+    int64_t min_recorded = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->min_recorded);
+
+    return min_recorded == INT64_MAX ? 0 : min_recorded;
+}
+
+// Gets the largest recorded value.
+int64_t teohistogramGetMax(const teohistogram* histogram) {
+    return TEOHISTOGRAM_ATOMIC_LOAD(&histogram->max_recorded);
+}
+
+// Gets arithmetic mean of recorded values.
+double teohistogramGetMean(const teohistogram* histogram) {
+    // Middle of bucket stands for all values counted in it.
+    double total = 0.0;
+    int64_t total_count = 0;
+
+    for (size_t i = 0; i < histogram->buckets_count; ++i) {
+        int64_t count = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->counts[i]);
+        if (count == 0) {
+            continue;
+        }
+
+        int64_t lowest_value = teohistogramGetLowestValue(histogram->precision_bits, i);
+        int64_t highest_value = teohistogramGetHighestValue(histogram->precision_bits, i);
+
+        total += ((double)lowest_value + (double)(highest_value - lowest_value) / 2.0) * (double)count;
+        total_count += count;
+    }
+
+    return total_count == 0 ? 0.0 : total / (double)total_count;
+}
+
+// Gets value at percentile.
+int64_t teohistogramGetValueAtPercentile(const teohistogram* histogram, double percentile) {
+    int64_t total_count = teohistogramGetCount(histogram);
+    if (total_count == 0) {
+        return 0;
+    }
+
+    if (percentile < 0.0) {
+        percentile = 0.0;
+    } else if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+
+    // Amount of values which must be at or below the result, at least one.
+    int64_t target_count = (int64_t)(percentile / 100.0 * (double)total_count + 0.5);
+    if (target_count < 1) {
+        target_count = 1;
+    }
+
+    int64_t max_recorded = teohistogramGetMax(histogram);
+    int64_t cumulative_count = 0;
+
+    for (size_t i = 0; i < histogram->buckets_count; ++i) {
+        cumulative_count += TEOHISTOGRAM_ATOMIC_LOAD(&histogram->counts[i]);
+
+        if (cumulative_count >= target_count) {
+            int64_t highest_value = teohistogramGetHighestValue(histogram->precision_bits, i);
+            return highest_value < max_recorded ? highest_value : max_recorded;
+        }
+    }
+
+    return max_recorded;
+}
+
+// Write unsigned variable length integer, seven bits per byte.
+static size_t teohistogramWriteVarint(uint8_t* buffer, uint64_t value) {
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    buffer[length++] = (uint8_t)value;
+    return length;
+}
+
+// Read unsigned variable length integer, returns amount of bytes read or zero if data is malformed.
+static size_t teohistogramReadVarint(const uint8_t* buffer, size_t buffer_size, uint64_t* value) {
+    *value = 0;
+
+    for (size_t i = 0; i < buffer_size && i < TEOHISTOGRAM_VARINT_MAX_LENGTH; ++i) {
+        *value |= (uint64_t)(buffer[i] & 0x7F) << (7 * i);
+
+        if ((buffer[i] & 0x80) == 0) {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+// Gets buffer size enough for teohistogramSerialize() with any recorded values.
+size_t teohistogramGetMaxSerializedSize(const teohistogram* histogram) {
+    // Header, three integers, one integer per bucket and trailer.
+    return TEOHISTOGRAM_MAGIC_LENGTH + 2 + (3 + histogram->buckets_count) * TEOHISTOGRAM_VARINT_MAX_LENGTH +
+           TEOHISTOGRAM_TRAILER_LENGTH;
+}
+
+// Stores histogram in compact binary form.
+size_t teohistogramSerialize(const teohistogram* histogram, uint8_t* buffer, size_t buffer_size) {
+    uint8_t varint[TEOHISTOGRAM_VARINT_MAX_LENGTH];
+
+    if (buffer_size < TEOHISTOGRAM_MAGIC_LENGTH + 2) {
+        return 0;
+    }
+
+    memcpy(buffer, TEOHISTOGRAM_MAGIC, TEOHISTOGRAM_MAGIC_LENGTH);
+    buffer[TEOHISTOGRAM_MAGIC_LENGTH] = TEOHISTOGRAM_VERSION;
+    buffer[TEOHISTOGRAM_MAGIC_LENGTH + 1] = (uint8_t)histogram->precision_bits;
+    size_t position = TEOHISTOGRAM_MAGIC_LENGTH + 2;
+
+    uint64_t header_values[3] = {
+        (uint64_t)histogram->max_value,
+        (uint64_t)TEOHISTOGRAM_ATOMIC_LOAD(&histogram->min_recorded),
+        (uint64_t)TEOHISTOGRAM_ATOMIC_LOAD(&histogram->max_recorded),
+    };
+
+    for (size_t i = 0; i < 3; ++i) {
+        size_t length = teohistogramWriteVarint(varint, header_values[i]);
+        if (buffer_size - position < length) {
+            return 0;
+        }
+
+        memcpy(buffer + position, varint, length);
+        position += length;
+    }
+
+    // Counts are zigzag encoded, negative value is a run of empty buckets.
+    int64_t empty_run = 0;
+    uint64_t total_count = 0;
+
+    for (size_t i = 0; i < histogram->buckets_count; ++i) {
+        int64_t count = TEOHISTOGRAM_ATOMIC_LOAD(&histogram->counts[i]);
+
+        if (count == 0) {
+            ++empty_run;
+            continue;
+        }
+
+        size_t length = 0;
+        if (empty_run != 0) {
+            length = teohistogramWriteVarint(varint, (uint64_t)empty_run * 2 - 1);
+            empty_run = 0;
+
+            if (buffer_size - position < length) {
+                return 0;
+            }
+
+            memcpy(buffer + position, varint, length);
+            position += length;
+        }
+
+        length = teohistogramWriteVarint(varint, (uint64_t)count * 2);
+        if (buffer_size - position < length) {
+            return 0;
+        }
+
+        memcpy(buffer + position, varint, length);
+        position += length;
+        total_count += (uint64_t)count;
+    }
+
+    if (buffer_size - position < TEOHISTOGRAM_TRAILER_LENGTH) {
+        return 0;
+    }
+
+    // Little endian regardless of platform.
+    for (size_t i = 0; i < TEOHISTOGRAM_TRAILER_LENGTH; ++i) {
+        buffer[position++] = (uint8_t)(total_count >> (8 * i));
+    }
+
+    return position;
+}
+
+// Creates a histogram from data stored by teohistogramSerialize().
+teohistogram* teohistogramDeserialize(const uint8_t* buffer, size_t buffer_size) {
+    if (buffer_size < TEOHISTOGRAM_MAGIC_LENGTH + 2 + TEOHISTOGRAM_TRAILER_LENGTH ||
+        memcmp(buffer, TEOHISTOGRAM_MAGIC, TEOHISTOGRAM_MAGIC_LENGTH) != 0 ||
+        buffer[TEOHISTOGRAM_MAGIC_LENGTH] != TEOHISTOGRAM_VERSION) {
+        return NULL;
+    }
+
+    uint64_t expected_count = 0;
+    for (size_t i = 0; i < TEOHISTOGRAM_TRAILER_LENGTH; ++i) {
+        expected_count |= (uint64_t)buffer[buffer_size - TEOHISTOGRAM_TRAILER_LENGTH + i] << (8 * i);
+    }
+
+    buffer_size -= TEOHISTOGRAM_TRAILER_LENGTH;
+
+    int precision_bits = buffer[TEOHISTOGRAM_MAGIC_LENGTH + 1];
+    size_t position = TEOHISTOGRAM_MAGIC_LENGTH + 2;
+
+    uint64_t header_values[3];
+    for (size_t i = 0; i < 3; ++i) {
+        size_t length = teohistogramReadVarint(buffer + position, buffer_size - position, &header_values[i]);
+        if (length == 0) {
+            return NULL;
+        }
+
+        position += length;
+    }
+
+    // Range is either empty or lies within [0, max_value].
+    bool empty_range = header_values[1] == (uint64_t)INT64_MAX && header_values[2] == 0;
+    if (!empty_range && (header_values[1] > header_values[2] || header_values[2] > header_values[0])) {
+        return NULL;
+    }
+
+    teohistogram* histogram = teohistogramCreate((int64_t)header_values[0], precision_bits);
+    if (histogram == NULL) {
+        return NULL;
+    }
+
+    histogram->min_recorded = (int64_t)header_values[1];
+    histogram->max_recorded = (int64_t)header_values[2];
+
+    size_t index = 0;
+    uint64_t total_count = 0;
+
+    while (position < buffer_size) {
+        uint64_t value;
+        size_t length = teohistogramReadVarint(buffer + position, buffer_size - position, &value);
+        if (length == 0) {
+            teohistogramDestroy(histogram);
+            return NULL;
+        }
+
+        position += length;
+
+        if (value & 1) {
+            // Run of empty buckets.
+            uint64_t empty_run = (value + 1) / 2;
+            if (empty_run > histogram->buckets_count - index) {
+                teohistogramDestroy(histogram);
+                return NULL;
+            }
+
+            index += (size_t)empty_run;
+            continue;
+        }
+
+        if (index >= histogram->buckets_count) {
+            teohistogramDestroy(histogram);
+            return NULL;
+        }
+
+        histogram->counts[index++] = (int64_t)(value / 2);
+        total_count += value / 2;
+    }
+
+    // Recorded values must have a range and a range must have recorded values.
+    if (total_count != expected_count || (total_count == 0) != empty_range) {
+        teohistogramDestroy(histogram);
+        return NULL;
+    }
+
+    return histogram;
+}
@@ -0,0 +1,346 @@
+#include "teobase/packet.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if defined(TEONET_OS_WINDOWS)
+#include "teobase/windows.h"
+#include <winsock2.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "teobase/logging.h"
+#include "teobase/mutex.h"
+
+#if defined(_MSC_VER)
+#define TEOSOCK_ATOMIC_INCREMENT(value) InterlockedIncrement((volatile LONG*)(value))
+#define TEOSOCK_ATOMIC_DECREMENT(value) InterlockedDecrement((volatile LONG*)(value))
+#else
+#define TEOSOCK_ATOMIC_INCREMENT(value) __atomic_add_fetch((value), 1, __ATOMIC_RELAXED)
+#define TEOSOCK_ATOMIC_DECREMENT(value) __atomic_sub_fetch((value), 1, __ATOMIC_ACQ_REL)
+#endif
+
+// Size of huge page used to round up huge page backed region.
+#define TEOSOCK_PACKET_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+#if defined(TEONET_OS_WINDOWS)
+#define TEOSOCK_PACKET_NO_BUFFERS WSAENOBUFS
+#else
+#define TEOSOCK_PACKET_NO_BUFFERS ENOBUFS
+#endif
+
+struct teosockPacketPool {
+    uint8_t* region;
+    size_t region_size;
+    size_t packets_count;
+
+    teonetMutex mutex;
+    teosockPacket* free_list;
+    size_t free_count;
+};
+
+// Round value up to multiple of alignment.
+static size_t teosockPacketAlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Allocate page aligned memory region, try huge pages if requested.
+static uint8_t* teosockPacketAllocRegion(size_t* region_size, int flags) {
+#if defined(TEONET_OS_WINDOWS)
+    return VirtualAlloc(NULL, *region_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+#if defined(TEONET_OS_LINUX) && defined(MAP_HUGETLB)
+    if (flags & TEOSOCK_PACKET_POOL_HUGEPAGES) {
+        size_t hugepage_region_size = teosockPacketAlignUp(*region_size, TEOSOCK_PACKET_HUGEPAGE_SIZE);
+
+        void* region = mmap(NULL, hugepage_region_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (region != MAP_FAILED) {
+            *region_size = hugepage_region_size;
+            return region;
+        }
+    }
+#endif
+
+    void* region = mmap(NULL, *region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return NULL;
+    }
+
+#if defined(TEONET_OS_LINUX) && defined(MADV_HUGEPAGE)
+    // Reserved huge pages are not available, ask for transparent huge pages instead.
+    if (flags & TEOSOCK_PACKET_POOL_HUGEPAGES) {
+        madvise(region, *region_size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return region;
+#endif
+}
+
+// Free memory region allocated by teosockPacketAllocRegion().
+static void teosockPacketFreeRegion(uint8_t* region, size_t region_size) {
+#if defined(TEONET_OS_WINDOWS)
+    VirtualFree(region, 0, MEM_RELEASE);
+#else
+    munmap(region, region_size);
+#endif
+}
+
+// Creates a packet pool.
+teosockPacketPool* teosockPacketPoolCreate(size_t packet_size, size_t packets_count, int flags) {
+    if (packet_size == 0 || packets_count == 0) {
+        return NULL;
+    }
+
+    teosockPacketPool* pool = calloc(1, sizeof(teosockPacketPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    // Header and payload of each packet start on their own cache lines.
+    size_t header_size = teosockPacketAlignUp(sizeof(teosockPacket), TEOSOCK_PACKET_ALIGNMENT);
+    size_t payload_size = teosockPacketAlignUp(packet_size, TEOSOCK_PACKET_ALIGNMENT);
+    size_t stride = header_size + payload_size;
+
+    pool->region_size = stride * packets_count;
+    pool->region = teosockPacketAllocRegion(&pool->region_size, flags);
+
+    if (pool->region == NULL) {
+        LTRACK_E("TeoBase", "Failed to allocate packet pool of %zu bytes.", pool->region_size);
+        free(pool);
+        return NULL;
+    }
+
+    pool->packets_count = packets_count;
+    teomutexInitialize(&pool->mutex);
+
+    // Build free list so that packets are taken in address order.
+    for (size_t i = packets_count; i > 0; --i) {
+        teosockPacket* packet = (teosockPacket*)(pool->region + (i - 1) * stride);
+        memset(packet, 0, sizeof(teosockPacket));
+        packet->data = (uint8_t*)packet + header_size;
+        packet->capacity = payload_size;
+        packet->pool = pool;
+        packet->next = pool->free_list;
+        pool->free_list = packet;
+    }
+
+    pool->free_count = packets_count;
+
+    return pool;
+}
+
+// Destroys a packet pool.
+void teosockPacketPoolDestroy(teosockPacketPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    if (pool->free_count != pool->packets_count) {
+        LTRACK_E("TeoBase", "Packet pool destroyed with %zu packets in use.", pool->packets_count - pool->free_count);
+    }
+
+    teomutexDestroy(&pool->mutex);
+    teosockPacketFreeRegion(pool->region, pool->region_size);
+    free(pool);
+}
+
+// Gets amount of packets in pool free list.
+size_t teosockPacketPoolGetFreeCount(teosockPacketPool* pool) {
+    teomutexLock(&pool->mutex);
+    size_t free_count = pool->free_count;
+    teomutexUnlock(&pool->mutex);
+
+    return free_count;
+}
+
+// Initializes per-thread packet cache.
+void teosockPacketCacheInit(teosockPacketCache* cache, teosockPacketPool* pool) {
+    cache->pool = pool;
+    cache->count = 0;
+}
+
+// Move packets from the end of cache to pool free list.
+static void teosockPacketCacheSpill(teosockPacketCache* cache, size_t count) {
+    teosockPacketPool* pool = cache->pool;
+
+    teomutexLock(&pool->mutex);
+
+    for (size_t i = 0; i < count; ++i) {
+        teosockPacket* packet = cache->packets[--cache->count];
+        packet->next = pool->free_list;
+        pool->free_list = packet;
+    }
+
+    pool->free_count += count;
+
+    teomutexUnlock(&pool->mutex);
+}
+
+// Move up to count packets from pool free list to cache.
+static void teosockPacketCacheRefill(teosockPacketCache* cache, size_t count) {
+    teosockPacketPool* pool = cache->pool;
+
+    teomutexLock(&pool->mutex);
+
+    while (count != 0 && pool->free_list != NULL) {
+        teosockPacket* packet = pool->free_list;
+        pool->free_list = packet->next;
+        --pool->free_count;
+
+        cache->packets[cache->count++] = packet;
+        --count;
+    }
+
+    teomutexUnlock(&pool->mutex);
+}
+
+// Returns all cached packets to pool.
+void teosockPacketCacheFlush(teosockPacketCache* cache) {
+    if (cache->count != 0) {
+        teosockPacketCacheSpill(cache, cache->count);
+    }
+}
+
+// Takes a packet from cache or pool.
+teosockPacket* teosockPacketAlloc(teosockPacketCache* cache) {
+    if (cache->count == 0) {
+        // Take half of cache at once, so that alloc and release in turns do not lock every time.
+        teosockPacketCacheRefill(cache, TEOSOCK_PACKET_CACHE_SIZE / 2);
+
+        if (cache->count == 0) {
+            return NULL;
+        }
+    }
+
+    teosockPacket* packet = cache->packets[--cache->count];
+    packet->next = NULL;
+    packet->length = 0;
+    packet->address_length = 0;
+    packet->reference_count = 1;
+
+    return packet;
+}
+
+// Increments packet reference count.
+void teosockPacketRetain(teosockPacket* packet) {
+    TEOSOCK_ATOMIC_INCREMENT(&packet->reference_count);
+}
+
+// Return packet directly to free list of its pool.
+static void teosockPacketPoolPush(teosockPacketPool* pool, teosockPacket* packet) {
+    teomutexLock(&pool->mutex);
+
+    packet->next = pool->free_list;
+    pool->free_list = packet;
+    ++pool->free_count;
+
+    teomutexUnlock(&pool->mutex);
+}
+
+// Decrements packet reference count.
+void teosockPacketRelease(teosockPacketCache* cache, teosockPacket* packet) {
+    if (TEOSOCK_ATOMIC_DECREMENT(&packet->reference_count) != 0) {
+        return;
+    }
+
+    // Packet of another pool must not end up in this cache, it would be spilled to the wrong pool.
+    if (cache->pool != packet->pool) {
+        teosockPacketPoolPush(packet->pool, packet);
+        return;
+    }
+
+    if (cache->count == TEOSOCK_PACKET_CACHE_SIZE) {
+        teosockPacketCacheSpill(cache, TEOSOCK_PACKET_CACHE_SIZE / 2);
+    }
+
+    cache->packets[cache->count++] = packet;
+}
+
+// Receives a datagram into a packet taken from cache.
+teosockRecvfromResult teosockRecvfromPacket(
+    teonetSocket socket_descriptor, teosockPacketCache* cache, teosockPacket** packet, int* error_code) {
+    teosockPacket* new_packet = teosockPacketAlloc(cache);
+
+    if (new_packet == NULL) {
+        if (error_code != NULL) {
+            *error_code = TEOSOCK_PACKET_NO_BUFFERS;
+        }
+
+        return TEOSOCK_RECVFROM_TRY_AGAIN;
+    }
+
+    new_packet->address_length = sizeof(new_packet->address);
+
+    teosockRecvfromResult result = teosockRecvfrom(socket_descriptor, new_packet->data, new_packet->capacity,
+        (struct sockaddr*)&new_packet->address, &new_packet->address_length, &new_packet->length, error_code);
+
+    if (result != TEOSOCK_RECVFROM_DATA_RECEIVED) {
+        teosockPacketRelease(cache, new_packet);
+        return result;
+    }
+
+    *packet = new_packet;
+    return result;
+}
+
+// Receives several datagrams into packets taken from cache.
+teosockRecvfromResult teosockRecvfromPacketBatch(
+    teonetSocket socket_descriptor, teosockPacketCache* cache, teosockPacket** packets, size_t packets_count,
+    size_t* received_count, int* error_code) {
+    *received_count = 0;
+
+    if (packets_count > TEOSOCK_PACKET_BATCH_SIZE) {
+        packets_count = TEOSOCK_PACKET_BATCH_SIZE;
+    }
+
+    teosockRecvfromMessage messages[TEOSOCK_PACKET_BATCH_SIZE];
+    size_t allocated_count = 0;
+
+    while (allocated_count < packets_count) {
+        teosockPacket* packet = teosockPacketAlloc(cache);
+        if (packet == NULL) {
+            break;
+        }
+
+        packets[allocated_count] = packet;
+        messages[allocated_count].buffer = packet->data;
+        messages[allocated_count].buffer_size = packet->capacity;
+        ++allocated_count;
+    }
+
+    if (allocated_count == 0) {
+        if (error_code != NULL) {
+            *error_code = TEOSOCK_PACKET_NO_BUFFERS;
+        }
+
+        return TEOSOCK_RECVFROM_TRY_AGAIN;
+    }
+
+    size_t count = 0;
+    teosockRecvfromResult result =
+        teosockRecvfromBatch(socket_descriptor, messages, allocated_count, &count, error_code);
+
+    for (size_t i = 0; i < count; ++i) {
+        packets[i]->length = messages[i].received_length;
+        packets[i]->address_length = messages[i].address_length;
+        memcpy(&packets[i]->address, &messages[i].address, messages[i].address_length);
+    }
+
+    // Return packets which were not filled.
+    for (size_t i = allocated_count; i > count; --i) {
+        teosockPacketRelease(cache, packets[i - 1]);
+        packets[i - 1] = NULL;
+    }
+
+    *received_count = count;
+    return result;
+}
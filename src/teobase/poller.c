@@ -0,0 +1,426 @@
+#include "teobase/poller.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if defined(TEONET_OS_WINDOWS)
+#include "teobase/windows.h"
+#include <winsock2.h>
+#elif defined(TEONET_OS_LINUX)
+#include <sys/epoll.h>
+#include <unistd.h>
+#else
+#include <poll.h>
+#endif
+
+#include "teobase/logging.h"
+#include "teobase/time.h"
+
+#if defined(TEONET_OS_LINUX)
+// Registration record of socket, indexed by socket descriptor.
+typedef struct teosockPollerEntry {
+    void* user_data;
+    bool registered;
+} teosockPollerEntry;
+
+struct teosockPoller {
+    int epoll_descriptor;
+    teosockPollerEntry* entries;
+    size_t entries_count;
+    struct epoll_event* ready_events;
+    int ready_events_count;
+};
+#else
+#if defined(TEONET_OS_WINDOWS)
+typedef WSAPOLLFD teosockPollfd;
+#else
+typedef struct pollfd teosockPollfd;
+#endif
+
+struct teosockPoller {
+    teosockPollfd* descriptors;
+    void** user_data;
+    size_t count;
+    size_t capacity;
+    // Index to start reporting from, so sockets at the end of array are not starved.
+    size_t next_index;
+};
+#endif
+
+// Creates a poller object.
+teosockPoller* teosockPollerCreate() {
+    teosockPoller* poller = calloc(1, sizeof(teosockPoller));
+
+    if (poller == NULL) {
+        return NULL;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    poller->epoll_descriptor = epoll_create1(EPOLL_CLOEXEC);
+
+    if (poller->epoll_descriptor == -1) {
+        LTRACK_E("TeoBase", "Failed to create epoll descriptor. Error code: %d.", errno);
+        free(poller);
+        return NULL;
+    }
+#endif
+
+    return poller;
+}
+
+// Destroys a poller object.
+void teosockPollerDestroy(teosockPoller* poller) {
+    if (poller == NULL) {
+        return;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    close(poller->epoll_descriptor);
+    free(poller->entries);
+    free(poller->ready_events);
+#else
+    free(poller->descriptors);
+    free(poller->user_data);
+#endif
+
+    free(poller);
+}
+
+#if defined(TEONET_OS_LINUX)
+// Convert teosockPollerEvents flags to epoll events.
+static uint32_t teosockPollerToEpollEvents(int events) {
+    uint32_t epoll_events = EPOLLRDHUP;
+
+    if (events & TEOSOCK_POLLER_READ) {
+        epoll_events |= EPOLLIN;
+    }
+
+    if (events & TEOSOCK_POLLER_WRITE) {
+        epoll_events |= EPOLLOUT;
+    }
+
+    if (events & TEOSOCK_POLLER_EDGE_TRIGGERED) {
+        epoll_events |= EPOLLET;
+    }
+
+    return epoll_events;
+}
+
+// Get registration record of socket, optionally growing entries table.
+static teosockPollerEntry* teosockPollerGetEntry(teosockPoller* poller, teonetSocket socket_descriptor, bool grow) {
+    if (socket_descriptor < 0) {
+        return NULL;
+    }
+
+    size_t index = (size_t)socket_descriptor;
+
+    if (index >= poller->entries_count) {
+        if (!grow) {
+            return NULL;
+        }
+
+        size_t new_count = poller->entries_count != 0 ? poller->entries_count : 64;
+        while (new_count <= index) {
+            new_count *= 2;
+        }
+
+        teosockPollerEntry* new_entries = realloc(poller->entries, new_count * sizeof(teosockPollerEntry));
+        if (new_entries == NULL) {
+            return NULL;
+        }
+
+        memset(new_entries + poller->entries_count, 0,
+               (new_count - poller->entries_count) * sizeof(teosockPollerEntry));
+
+        poller->entries = new_entries;
+        poller->entries_count = new_count;
+    }
+
+    return &poller->entries[index];
+}
+#else
+// Convert teosockPollerEvents flags to poll() events.
+static short teosockPollerToPollEvents(int events) {
+    short poll_events = 0;
+
+    if (events & TEOSOCK_POLLER_READ) {
+        poll_events |= POLLIN;
+    }
+
+    if (events & TEOSOCK_POLLER_WRITE) {
+        poll_events |= POLLOUT;
+    }
+
+    return poll_events;
+}
+
+// Find index of socket in descriptors array. Returns count if socket is not registered.
+static size_t teosockPollerFind(const teosockPoller* poller, teonetSocket socket_descriptor) {
+    size_t index = 0;
+
+    while (index < poller->count && poller->descriptors[index].fd != socket_descriptor) {
+        ++index;
+    }
+
+    return index;
+}
+#endif
+
+// Registers a socket in poller.
+int teosockPollerAdd(teosockPoller* poller, teonetSocket socket_descriptor, int events, void* user_data) {
+#if defined(TEONET_OS_LINUX)
+    teosockPollerEntry* entry = teosockPollerGetEntry(poller, socket_descriptor, true);
+
+    if (entry == NULL || entry->registered) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = teosockPollerToEpollEvents(events);
+    event.data.fd = socket_descriptor;
+
+    if (epoll_ctl(poller->epoll_descriptor, EPOLL_CTL_ADD, socket_descriptor, &event) != 0) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    entry->user_data = user_data;
+    entry->registered = true;
+#else
+    if (teosockPollerFind(poller, socket_descriptor) != poller->count) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    if (poller->count == poller->capacity) {
+        size_t new_capacity = poller->capacity != 0 ? poller->capacity * 2 : 16;
+
+        teosockPollfd* new_descriptors = realloc(poller->descriptors, new_capacity * sizeof(teosockPollfd));
+        if (new_descriptors == NULL) {
+            return TEOSOCK_SOCKET_ERROR;
+        }
+        poller->descriptors = new_descriptors;
+
+        void** new_user_data = realloc(poller->user_data, new_capacity * sizeof(void*));
+        if (new_user_data == NULL) {
+            return TEOSOCK_SOCKET_ERROR;
+        }
+        poller->user_data = new_user_data;
+
+        poller->capacity = new_capacity;
+    }
+
+    teosockPollfd* descriptor = &poller->descriptors[poller->count];
+    memset(descriptor, 0, sizeof(*descriptor));
+    descriptor->fd = socket_descriptor;
+    descriptor->events = teosockPollerToPollEvents(events);
+
+    poller->user_data[poller->count] = user_data;
+    ++poller->count;
+#endif
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Changes watched events and user data of registered socket.
+int teosockPollerModify(teosockPoller* poller, teonetSocket socket_descriptor, int events, void* user_data) {
+#if defined(TEONET_OS_LINUX)
+    teosockPollerEntry* entry = teosockPollerGetEntry(poller, socket_descriptor, false);
+
+    if (entry == NULL || !entry->registered) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = teosockPollerToEpollEvents(events);
+    event.data.fd = socket_descriptor;
+
+    if (epoll_ctl(poller->epoll_descriptor, EPOLL_CTL_MOD, socket_descriptor, &event) != 0) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    entry->user_data = user_data;
+#else
+    size_t index = teosockPollerFind(poller, socket_descriptor);
+
+    if (index == poller->count) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    poller->descriptors[index].events = teosockPollerToPollEvents(events);
+    poller->user_data[index] = user_data;
+#endif
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Unregisters socket from poller.
+int teosockPollerRemove(teosockPoller* poller, teonetSocket socket_descriptor) {
+#if defined(TEONET_OS_LINUX)
+    teosockPollerEntry* entry = teosockPollerGetEntry(poller, socket_descriptor, false);
+
+    if (entry == NULL || !entry->registered) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    entry->registered = false;
+    entry->user_data = NULL;
+
+    // Event argument is ignored but must be non-null on kernels before 2.6.9.
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+
+    if (epoll_ctl(poller->epoll_descriptor, EPOLL_CTL_DEL, socket_descriptor, &event) != 0) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+#else
+    size_t index = teosockPollerFind(poller, socket_descriptor);
+
+    if (index == poller->count) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    // Move last socket in place of removed one.
+    --poller->count;
+    poller->descriptors[index] = poller->descriptors[poller->count];
+    poller->user_data[index] = poller->user_data[poller->count];
+#endif
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Waits for events on registered sockets.
+int teosockPollerWait(teosockPoller* poller, teosockPollerEvent* events, int max_events, int timeout_ms) {
+    if (max_events <= 0) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    if (timeout_ms < 0) {
+        timeout_ms = -1;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    if (poller->ready_events_count < max_events) {
+        struct epoll_event* new_ready_events = realloc(poller->ready_events, (size_t)max_events * sizeof(struct epoll_event));
+        if (new_ready_events == NULL) {
+            return TEOSOCK_SOCKET_ERROR;
+        }
+
+        poller->ready_events = new_ready_events;
+        poller->ready_events_count = max_events;
+    }
+
+    int ready_count = epoll_wait(poller->epoll_descriptor, poller->ready_events, max_events, timeout_ms);
+    int wait_errno = errno;
+
+    // Events are handled after waking up, give handlers fresh cached time.
+    // Refresh may change errno, restore it for the error check and for the caller.
+    teotimeRefreshCachedTime();
+    errno = wait_errno;
+
+    if (ready_count == -1) {
+        return errno == EINTR ? 0 : TEOSOCK_SOCKET_ERROR;
+    }
+
+    for (int i = 0; i < ready_count; ++i) {
+        const struct epoll_event* ready_event = &poller->ready_events[i];
+        teosockPollerEvent* event = &events[i];
+
+        event->socket_descriptor = ready_event->data.fd;
+        event->user_data = poller->entries[ready_event->data.fd].user_data;
+        event->events = 0;
+
+        if (ready_event->events & EPOLLIN) {
+            event->events |= TEOSOCK_POLLER_READ;
+        }
+
+        if (ready_event->events & EPOLLOUT) {
+            event->events |= TEOSOCK_POLLER_WRITE;
+        }
+
+        if (ready_event->events & EPOLLERR) {
+            event->events |= TEOSOCK_POLLER_ERROR;
+        }
+
+        if (ready_event->events & (EPOLLHUP | EPOLLRDHUP)) {
+            event->events |= TEOSOCK_POLLER_HANGUP;
+        }
+    }
+
+    return ready_count;
+#else
+#if defined(TEONET_OS_WINDOWS)
+    int poll_result = WSAPoll(poller->descriptors, (ULONG)poller->count, timeout_ms);
+    int wait_error = WSAGetLastError();
+#else
+    int poll_result = poll(poller->descriptors, (nfds_t)poller->count, timeout_ms);
+    int wait_error = errno;
+#endif
+
+    // Events are handled after waking up, give handlers fresh cached time.
+    // Refresh may change error code, restore it for the error check and for the caller.
+    teotimeRefreshCachedTime();
+#if defined(TEONET_OS_WINDOWS)
+    WSASetLastError(wait_error);
+#else
+    errno = wait_error;
+#endif
+
+    if (poll_result < 0) {
+#if defined(TEONET_OS_WINDOWS)
+        return TEOSOCK_SOCKET_ERROR;
+#else
+        return errno == EINTR ? 0 : TEOSOCK_SOCKET_ERROR;
+#endif
+    }
+
+    int ready_count = 0;
+
+    if (poller->next_index >= poller->count) {
+        poller->next_index = 0;
+    }
+
+    for (size_t i = 0; i < poller->count && poll_result > 0 && ready_count < max_events; ++i) {
+        size_t index = (poller->next_index + i) % poller->count;
+        const teosockPollfd* descriptor = &poller->descriptors[index];
+
+        if (descriptor->revents == 0) {
+            continue;
+        }
+
+        --poll_result;
+
+        teosockPollerEvent* event = &events[ready_count];
+        ++ready_count;
+
+        event->socket_descriptor = descriptor->fd;
+        event->user_data = poller->user_data[index];
+        event->events = 0;
+
+        if (descriptor->revents & POLLIN) {
+            event->events |= TEOSOCK_POLLER_READ;
+        }
+
+        if (descriptor->revents & POLLOUT) {
+            event->events |= TEOSOCK_POLLER_WRITE;
+        }
+
+        if (descriptor->revents & (POLLERR | POLLNVAL)) {
+            event->events |= TEOSOCK_POLLER_ERROR;
+        }
+
+        if (descriptor->revents & POLLHUP) {
+            event->events |= TEOSOCK_POLLER_HANGUP;
+        }
+
+        poller->next_index = index + 1;
+    }
+
+    return ready_count;
+#endif
+}
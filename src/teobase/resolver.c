@@ -0,0 +1,641 @@
+#include "teobase/resolver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if defined(TEONET_OS_WINDOWS)
+#include "teobase/windows.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#endif
+
+#include "teobase/logging.h"
+#include "teobase/mutex.h"
+#include "teobase/time.h"
+
+// Maximum amount of threads resolving host names in background.
+#define TEOSOCK_RESOLVER_WORKERS_COUNT 4
+
+// Finished uncached resolution is kept for caller at least this long, even if negative TTL is shorter.
+#define TEOSOCK_RESOLVER_MIN_REQUEST_TTL_MS MILLISECONDS_IN_SECOND
+
+// Cached resolution of a host name.
+typedef struct teosockResolverEntry {
+    // Empty string marks unused entry.
+    char host[TEOSOCK_RESOLVER_MAX_HOST_LENGTH];
+    teosockResolvedAddresses addresses;
+    int64_t expires_ms;
+    int64_t last_used_ms;
+    // Entry contains result of resolution.
+    bool valid;
+    bool negative;
+    // Background resolution is in progress.
+    bool resolving;
+    // Result of background resolution was not returned yet by teosockResolveNonBlocking().
+    bool unreported;
+} teosockResolverEntry;
+
+// Background resolution of host which has no cache entry, because cache is disabled,
+// has no free entries or host name is too long to be cached.
+typedef struct teosockResolverRequest {
+    struct teosockResolverRequest* next;
+    char* host;
+    teosockResolveResult result;
+    teosockResolvedAddresses addresses;
+    bool done;
+    // Finished request which was not collected by this time is dropped.
+    int64_t expires_ms;
+} teosockResolverRequest;
+
+// Host name waiting for a background worker.
+typedef struct teosockResolverJob {
+    struct teosockResolverJob* next;
+    char* host;
+} teosockResolverJob;
+
+static teonetMutex resolver_mutex;
+static teosockResolverConfig resolver_config;
+static teosockResolverEntry* resolver_entries = NULL;
+static size_t resolver_entries_count = 0;
+static teosockResolverRequest* resolver_requests = NULL;
+
+// Queue of background jobs and workers taking them, protected by resolver_mutex.
+static teosockResolverJob* resolver_jobs_head = NULL;
+static teosockResolverJob* resolver_jobs_tail = NULL;
+static size_t resolver_workers_count = 0;
+static size_t resolver_idle_workers_count = 0;
+
+#if defined(TEONET_OS_WINDOWS)
+static CONDITION_VARIABLE resolver_jobs_condition = CONDITION_VARIABLE_INIT;
+#else
+static pthread_cond_t resolver_jobs_condition = PTHREAD_COND_INITIALIZER;
+#endif
+
+static void teosockResolverInitializeOnce(void) {
+    teomutexInitialize(&resolver_mutex);
+    teosockResolverGetDefaultConfig(&resolver_config);
+
+    resolver_entries = calloc(resolver_config.max_entries, sizeof(teosockResolverEntry));
+    resolver_entries_count = resolver_entries != NULL ? resolver_config.max_entries : 0;
+    resolver_config.max_entries = resolver_entries_count;
+}
+
+#if defined(TEONET_OS_WINDOWS)
+static INIT_ONCE resolver_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK teosockResolverInitOnceCallback(PINIT_ONCE init_once, PVOID parameter, PVOID* context) {
+    teosockResolverInitializeOnce();
+    return TRUE;
+}
+#else
+static pthread_once_t resolver_once = PTHREAD_ONCE_INIT;
+#endif
+
+// Initialize resolver mutex and configuration on first use.
+static void teosockResolverInitialize(void) {
+#if defined(TEONET_OS_WINDOWS)
+    InitOnceExecuteOnce(&resolver_once, teosockResolverInitOnceCallback, NULL, NULL);
+#else
+    pthread_once(&resolver_once, teosockResolverInitializeOnce);
+#endif
+}
+
+// Get default resolver configuration.
+void teosockResolverGetDefaultConfig(teosockResolverConfig* config) {
+    memset(config, 0, sizeof(*config));
+    config->ttl_ms = 60 * MILLISECONDS_IN_SECOND;
+    config->negative_ttl_ms = 5 * MILLISECONDS_IN_SECOND;
+    config->refresh_ahead_ms = 10 * MILLISECONDS_IN_SECOND;
+    config->async_refresh = false;
+    config->max_entries = 256;
+}
+
+// Set resolver configuration.
+void teosockResolverConfigure(const teosockResolverConfig* config) {
+    teosockResolverInitialize();
+
+    teomutexLock(&resolver_mutex);
+
+    if (config->max_entries != resolver_entries_count) {
+        // Shrinking drops entries at the end, background resolutions re-insert their results.
+        teosockResolverEntry* new_entries = NULL;
+
+        if (config->max_entries != 0) {
+            new_entries = realloc(resolver_entries, config->max_entries * sizeof(teosockResolverEntry));
+        } else {
+            free(resolver_entries);
+        }
+
+        if (new_entries != NULL || config->max_entries == 0) {
+            if (config->max_entries > resolver_entries_count) {
+                memset(new_entries + resolver_entries_count, 0,
+                       (config->max_entries - resolver_entries_count) * sizeof(teosockResolverEntry));
+            }
+
+            resolver_entries = new_entries;
+            resolver_entries_count = config->max_entries;
+        }
+    }
+
+    resolver_config = *config;
+    resolver_config.max_entries = resolver_entries_count;
+
+    teomutexUnlock(&resolver_mutex);
+}
+
+// Resolve host using system resolver.
+static teosockResolveResult teosockResolverLookup(const char* host, int flags, teosockResolvedAddresses* addresses) {
+    struct addrinfo hints;
+    struct addrinfo* res;
+    memset(&hints, '\0', sizeof(struct addrinfo));
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = flags;
+
+    addresses->count = 0;
+
+    int n = getaddrinfo(host, NULL, &hints, &res);
+    if (n != 0) {
+        if ((flags & AI_NUMERICHOST) == 0) {
+            LTRACK_E("TeonetClient", "getaddrinfo: %s", gai_strerror(n));
+        }
+
+        return TEOSOCK_RESOLVE_NOT_FOUND;
+    }
+
+    for (struct addrinfo* rp = res; rp != NULL && addresses->count < TEOSOCK_RESOLVER_MAX_ADDRESSES; rp = rp->ai_next) {
+        if ((rp->ai_family != AF_INET && rp->ai_family != AF_INET6) ||
+            rp->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+
+        teosockResolvedAddress* address = &addresses->addresses[addresses->count];
+        memset(address, 0, sizeof(*address));
+        memcpy(&address->address, rp->ai_addr, rp->ai_addrlen);
+        address->address_length = (socklen_t)rp->ai_addrlen;
+        address->family = rp->ai_family;
+
+        ++addresses->count;
+    }
+
+    freeaddrinfo(res);
+
+    return addresses->count != 0 ? TEOSOCK_RESOLVE_SUCCESS : TEOSOCK_RESOLVE_NOT_FOUND;
+}
+
+// Set port in all resolved addresses.
+static void teosockResolverSetPort(teosockResolvedAddresses* addresses, uint16_t port) {
+    for (size_t i = 0; i < addresses->count; ++i) {
+        teosockResolvedAddress* address = &addresses->addresses[i];
+
+        if (address->family == AF_INET) {
+            ((struct sockaddr_in*)&address->address)->sin_port = htons(port);
+        } else if (address->family == AF_INET6) {
+            ((struct sockaddr_in6*)&address->address)->sin6_port = htons(port);
+        }
+    }
+}
+
+// Find cache entry of host. Must be called with locked mutex.
+static teosockResolverEntry* teosockResolverFind(const char* host) {
+    for (size_t i = 0; i < resolver_entries_count; ++i) {
+        if (resolver_entries[i].host[0] != '\0' && strcmp(resolver_entries[i].host, host) == 0) {
+            return &resolver_entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Get cache entry for host, reusing free or least recently used entry. Must be called with locked mutex.
+static teosockResolverEntry* teosockResolverFindOrInsert(const char* host, int64_t now_ms) {
+    teosockResolverEntry* entry = teosockResolverFind(host);
+    if (entry != NULL) {
+        return entry;
+    }
+
+    for (size_t i = 0; i < resolver_entries_count; ++i) {
+        teosockResolverEntry* candidate = &resolver_entries[i];
+
+        // Entries with background resolution in progress are not evicted.
+        if (candidate->resolving) {
+            continue;
+        }
+
+        if (candidate->host[0] == '\0') {
+            entry = candidate;
+            break;
+        }
+
+        if (entry == NULL || candidate->last_used_ms < entry->last_used_ms) {
+            entry = candidate;
+        }
+    }
+
+    if (entry != NULL) {
+        memset(entry, 0, sizeof(*entry));
+        snprintf(entry->host, sizeof(entry->host), "%s", host);
+        entry->last_used_ms = now_ms;
+    }
+
+    return entry;
+}
+
+// Store resolution result in cache entry. Must be called with locked mutex.
+static void teosockResolverStore(teosockResolverEntry* entry, teosockResolveResult result,
+                                 const teosockResolvedAddresses* addresses, int64_t now_ms) {
+    entry->valid = true;
+    entry->negative = result != TEOSOCK_RESOLVE_SUCCESS;
+
+    if (entry->negative) {
+        entry->addresses.count = 0;
+        entry->expires_ms = now_ms + resolver_config.negative_ttl_ms;
+    } else {
+        entry->addresses = *addresses;
+        entry->expires_ms = now_ms + resolver_config.ttl_ms;
+    }
+}
+
+// Store result of background resolution in requests and cache. Must be called with locked mutex.
+static void teosockResolverComplete(
+    const char* host, teosockResolveResult result, const teosockResolvedAddresses* addresses) {
+    int64_t now_ms = teotimeGetMonotonicMs();
+
+    int64_t request_ttl_ms = resolver_config.negative_ttl_ms;
+    if (request_ttl_ms < TEOSOCK_RESOLVER_MIN_REQUEST_TTL_MS) {
+        request_ttl_ms = TEOSOCK_RESOLVER_MIN_REQUEST_TTL_MS;
+    }
+
+    for (teosockResolverRequest* request = resolver_requests; request != NULL; request = request->next) {
+        if (!request->done && strcmp(request->host, host) == 0) {
+            request->result = result;
+            request->addresses = *addresses;
+            request->done = true;
+            request->expires_ms = now_ms + request_ttl_ms;
+        }
+    }
+
+    teosockResolverEntry* entry = NULL;
+
+    if (strlen(host) < TEOSOCK_RESOLVER_MAX_HOST_LENGTH) {
+        entry = teosockResolverFindOrInsert(host, now_ms);
+    }
+
+    if (entry != NULL) {
+        // Failed refresh keeps serving previous addresses until they expire.
+        bool keep_previous = result != TEOSOCK_RESOLVE_SUCCESS && entry->valid && !entry->negative &&
+                             now_ms < entry->expires_ms;
+
+        if (!keep_previous) {
+            teosockResolverStore(entry, result, addresses, now_ms);
+        }
+
+        entry->resolving = false;
+        entry->unreported = true;
+    }
+}
+
+// Wait until a job is queued. Must be called with locked mutex, which is released while waiting.
+static void teosockResolverWaitJob(void) {
+#if defined(TEONET_OS_WINDOWS)
+    SleepConditionVariableCS(&resolver_jobs_condition, &resolver_mutex.critical_section, INFINITE);
+#else
+    pthread_cond_wait(&resolver_jobs_condition, &resolver_mutex.mutex);
+#endif
+}
+
+// Wake one idle worker. Must be called with locked mutex.
+static void teosockResolverSignalJob(void) {
+#if defined(TEONET_OS_WINDOWS)
+    WakeConditionVariable(&resolver_jobs_condition);
+#else
+    pthread_cond_signal(&resolver_jobs_condition);
+#endif
+}
+
+// Background worker, resolves queued host names one by one and never exits.
+#if defined(TEONET_OS_WINDOWS)
+static DWORD WINAPI teosockResolverThread(LPVOID argument)
+#else
+static void* teosockResolverThread(void* argument)
+#endif
+{
+    (void)argument;
+
+    teomutexLock(&resolver_mutex);
+
+    for (;;) {
+        while (resolver_jobs_head == NULL) {
+            ++resolver_idle_workers_count;
+            teosockResolverWaitJob();
+            --resolver_idle_workers_count;
+        }
+
+        teosockResolverJob* job = resolver_jobs_head;
+        resolver_jobs_head = job->next;
+        if (resolver_jobs_head == NULL) {
+            resolver_jobs_tail = NULL;
+        }
+
+        teomutexUnlock(&resolver_mutex);
+
+        // Resolve without holding the lock, so other threads can use cache meanwhile.
+        teosockResolvedAddresses addresses;
+        teosockResolveResult result = teosockResolverLookup(job->host, 0, &addresses);
+
+        teomutexLock(&resolver_mutex);
+
+        teosockResolverComplete(job->host, result, &addresses);
+
+        free(job->host);
+        free(job);
+    }
+
+#if defined(TEONET_OS_WINDOWS)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+// Start one more background worker, returns false on error. Must be called with locked mutex.
+static bool teosockResolverStartWorker(void) {
+#if defined(TEONET_OS_WINDOWS)
+    HANDLE thread = CreateThread(NULL, 0, teosockResolverThread, NULL, 0, NULL);
+    bool started = thread != NULL;
+
+    if (started) {
+        CloseHandle(thread);
+    }
+#else
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    pthread_t thread;
+    bool started = pthread_create(&thread, &attributes, teosockResolverThread, NULL) == 0;
+
+    pthread_attr_destroy(&attributes);
+#endif
+
+    if (!started) {
+        LTRACK_E("TeoBase", "Failed to start resolver thread.");
+        return false;
+    }
+
+    ++resolver_workers_count;
+
+    return true;
+}
+
+// Queue background resolution of host, returns false on error. Must be called with locked mutex.
+static bool teosockResolverQueueJob(const char* host_name) {
+    // Workers are started on demand up to a fixed limit, then jobs wait in queue.
+    if (resolver_idle_workers_count == 0 && resolver_workers_count < TEOSOCK_RESOLVER_WORKERS_COUNT) {
+        if (!teosockResolverStartWorker() && resolver_workers_count == 0) {
+            return false;
+        }
+    }
+
+    teosockResolverJob* job = calloc(1, sizeof(teosockResolverJob));
+    if (job == NULL) {
+        return false;
+    }
+
+    size_t host_length = strlen(host_name) + 1;
+    job->host = malloc(host_length);
+
+    if (job->host == NULL) {
+        free(job);
+        return false;
+    }
+
+    memcpy(job->host, host_name, host_length);
+
+    if (resolver_jobs_tail != NULL) {
+        resolver_jobs_tail->next = job;
+    } else {
+        resolver_jobs_head = job;
+    }
+
+    resolver_jobs_tail = job;
+
+    teosockResolverSignalJob();
+
+    return true;
+}
+
+// Start background resolution of cache entry. Must be called with locked mutex.
+static void teosockResolverStartBackground(teosockResolverEntry* entry) {
+    if (teosockResolverQueueJob(entry->host)) {
+        entry->resolving = true;
+    }
+}
+
+// Drop finished requests of other hosts which were not collected in time. Must be called with locked mutex.
+static void teosockResolverDropExpiredRequests(const char* host, int64_t now_ms) {
+    teosockResolverRequest** link = &resolver_requests;
+
+    while (*link != NULL) {
+        teosockResolverRequest* request = *link;
+
+        if (request->done && now_ms >= request->expires_ms && strcmp(request->host, host) != 0) {
+            *link = request->next;
+            free(request->host);
+            free(request);
+        } else {
+            link = &request->next;
+        }
+    }
+}
+
+// Resolve host which can not be cached in background, returns result once it is ready.
+// Must be called with locked mutex.
+static teosockResolveResult teosockResolverRequestUncached(
+    const char* host, int64_t now_ms, teosockResolvedAddresses* addresses) {
+    teosockResolverDropExpiredRequests(host, now_ms);
+
+    teosockResolverRequest** link = &resolver_requests;
+
+    while (*link != NULL && strcmp((*link)->host, host) != 0) {
+        link = &(*link)->next;
+    }
+
+    teosockResolverRequest* request = *link;
+
+    if (request != NULL) {
+        if (!request->done) {
+            return TEOSOCK_RESOLVE_PENDING;
+        }
+
+        teosockResolveResult result = request->result;
+        *addresses = request->addresses;
+
+        *link = request->next;
+        free(request->host);
+        free(request);
+
+        return result;
+    }
+
+    request = calloc(1, sizeof(teosockResolverRequest));
+    if (request == NULL) {
+        return TEOSOCK_RESOLVE_NOT_FOUND;
+    }
+
+    size_t host_length = strlen(host) + 1;
+    request->host = malloc(host_length);
+
+    if (request->host == NULL || !teosockResolverQueueJob(host)) {
+        free(request->host);
+        free(request);
+        return TEOSOCK_RESOLVE_NOT_FOUND;
+    }
+
+    memcpy(request->host, host, host_length);
+    request->next = resolver_requests;
+    resolver_requests = request;
+
+    return TEOSOCK_RESOLVE_PENDING;
+}
+
+// Copy cached result of entry. Must be called with locked mutex.
+static teosockResolveResult teosockResolverGetCached(teosockResolverEntry* entry, int64_t now_ms,
+                                                     teosockResolvedAddresses* addresses) {
+    entry->last_used_ms = now_ms;
+
+    if (entry->negative) {
+        return TEOSOCK_RESOLVE_NOT_FOUND;
+    }
+
+    *addresses = entry->addresses;
+
+    if (resolver_config.async_refresh && !entry->resolving &&
+        entry->expires_ms - now_ms <= resolver_config.refresh_ahead_ms) {
+        teosockResolverStartBackground(entry);
+    }
+
+    return TEOSOCK_RESOLVE_SUCCESS;
+}
+
+// Resolves host name using cache.
+teosockResolveResult teosockResolve(const char* host, uint16_t port, teosockResolvedAddresses* addresses) {
+    // IP address literals do not need to be cached.
+    if (teosockResolverLookup(host, AI_NUMERICHOST, addresses) == TEOSOCK_RESOLVE_SUCCESS) {
+        teosockResolverSetPort(addresses, port);
+        return TEOSOCK_RESOLVE_SUCCESS;
+    }
+
+    if (strlen(host) >= TEOSOCK_RESOLVER_MAX_HOST_LENGTH) {
+        teosockResolveResult result = teosockResolverLookup(host, 0, addresses);
+        teosockResolverSetPort(addresses, port);
+        return result;
+    }
+
+    teosockResolverInitialize();
+
+    teomutexLock(&resolver_mutex);
+
+    int64_t now_ms = teotimeGetMonotonicMs();
+    teosockResolverEntry* entry = teosockResolverFind(host);
+
+    if (entry != NULL && entry->valid && now_ms < entry->expires_ms) {
+        teosockResolveResult result = teosockResolverGetCached(entry, now_ms, addresses);
+        teomutexUnlock(&resolver_mutex);
+
+        teosockResolverSetPort(addresses, port);
+        return result;
+    }
+
+    teomutexUnlock(&resolver_mutex);
+
+    // Resolve without holding the lock, so other threads can use cache meanwhile.
+    teosockResolveResult result = teosockResolverLookup(host, 0, addresses);
+
+    teomutexLock(&resolver_mutex);
+
+    int64_t ttl_ms = result == TEOSOCK_RESOLVE_SUCCESS ? resolver_config.ttl_ms : resolver_config.negative_ttl_ms;
+    if (ttl_ms > 0) {
+        now_ms = teotimeGetMonotonicMs();
+        entry = teosockResolverFindOrInsert(host, now_ms);
+
+        if (entry != NULL) {
+            teosockResolverStore(entry, result, addresses, now_ms);
+        }
+    }
+
+    teomutexUnlock(&resolver_mutex);
+
+    teosockResolverSetPort(addresses, port);
+
+    return result;
+}
+
+// Resolves host name using cache without blocking.
+teosockResolveResult teosockResolveNonBlocking(const char* host, uint16_t port, teosockResolvedAddresses* addresses) {
+    if (teosockResolverLookup(host, AI_NUMERICHOST, addresses) == TEOSOCK_RESOLVE_SUCCESS) {
+        teosockResolverSetPort(addresses, port);
+        return TEOSOCK_RESOLVE_SUCCESS;
+    }
+
+    teosockResolverInitialize();
+
+    teomutexLock(&resolver_mutex);
+
+    int64_t now_ms = teotimeGetMonotonicMs();
+    teosockResolverEntry* entry = NULL;
+
+    if (strlen(host) < TEOSOCK_RESOLVER_MAX_HOST_LENGTH) {
+        entry = teosockResolverFindOrInsert(host, now_ms);
+    }
+
+    teosockResolveResult result;
+
+    if (entry == NULL) {
+        // Cache is disabled, full of pending resolutions or host name is too long.
+        result = teosockResolverRequestUncached(host, now_ms, addresses);
+    } else if (entry->valid && (now_ms < entry->expires_ms || entry->unreported)) {
+        entry->unreported = false;
+        result = teosockResolverGetCached(entry, now_ms, addresses);
+    } else {
+        if (!entry->resolving) {
+            teosockResolverStartBackground(entry);
+        }
+
+        result = entry->resolving ? TEOSOCK_RESOLVE_PENDING : TEOSOCK_RESOLVE_NOT_FOUND;
+    }
+
+    teomutexUnlock(&resolver_mutex);
+
+    if (result == TEOSOCK_RESOLVE_SUCCESS) {
+        teosockResolverSetPort(addresses, port);
+    }
+
+    return result;
+}
+
+// Removes all entries from resolver cache.
+void teosockResolverFlush() {
+    teosockResolverInitialize();
+
+    teomutexLock(&resolver_mutex);
+
+    for (size_t i = 0; i < resolver_entries_count; ++i) {
+        // Entries with background resolution in progress are kept to not start it again.
+        if (!resolver_entries[i].resolving) {
+            memset(&resolver_entries[i], 0, sizeof(resolver_entries[i]));
+        }
+    }
+
+    teomutexUnlock(&resolver_mutex);
+}
@@ -1,7 +1,14 @@
+// Needed for recvmmsg() and sendmmsg() declarations on Linux.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "teobase/socket.h"
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "teobase/types.h"
 
@@ -18,15 +25,78 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
-#include <sys/select.h>
+#include <netinet/udp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <unistd.h>
 #endif
 
+#if defined(TEONET_OS_WINDOWS)
+#include <io.h>
+#elif defined(TEONET_OS_LINUX)
+#include <sys/sendfile.h>
+#endif
+
 #include "teobase/logging.h"
+#include "teobase/resolver.h"
 #include "teobase/time.h"
 
+#if defined(TEONET_OS_LINUX)
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+
+// Older C libraries may miss zero-copy, UDP segmentation offload, reuseport, tuning and Fast Open options.
+#if !defined(SO_ZEROCOPY)
+#define SO_ZEROCOPY 60
+#endif
+#if !defined(MSG_ZEROCOPY)
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#if !defined(SO_EE_ORIGIN_ZEROCOPY)
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#if !defined(SO_EE_CODE_ZEROCOPY_COPIED)
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#if !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#if !defined(UDP_GRO)
+#define UDP_GRO 104
+#endif
+#if !defined(SO_REUSEPORT)
+#define SO_REUSEPORT 15
+#endif
+#if !defined(SO_INCOMING_CPU)
+#define SO_INCOMING_CPU 49
+#endif
+#if !defined(SO_ATTACH_REUSEPORT_CBPF)
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+#if !defined(SO_EE_ORIGIN_TIMESTAMPING)
+#define SO_EE_ORIGIN_TIMESTAMPING 4
+#endif
+#if !defined(SO_BUSY_POLL)
+#define SO_BUSY_POLL 46
+#endif
+#if !defined(TCP_NOTSENT_LOWAT)
+#define TCP_NOTSENT_LOWAT 25
+#endif
+#if !defined(TCP_FASTOPEN)
+#define TCP_FASTOPEN 23
+#endif
+#if !defined(TCP_FASTOPEN_CONNECT)
+#define TCP_FASTOPEN_CONNECT 30
+#endif
+#if !defined(MSG_FASTOPEN)
+#define MSG_FASTOPEN 0x20000000
+#endif
+#endif
+
 // Set value of timeval structure to time value specified in milliseconds.
 void teosockTimevalFromMs(struct timeval* timeval_ptr, int64_t time_value_ms) {
     if (time_value_ms != 0) {
@@ -58,326 +128,2539 @@ teonetSocket teosockCreateTcp() {
     return socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
 }
 
-// Establishes a connection to a specified server.
-teosockConnectResult teosockConnect(teonetSocket socket_descriptor, const char* server, uint16_t port) {
-    struct sockaddr_in serveraddr;
+// Creates a UDP socket.
+teonetSocket teosockCreateUdp() {
+    return socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+}
+
+// Option to spread incoming connections and datagrams between sockets bound to the same port.
+#if defined(SO_REUSEPORT_LB)
+#define TEOSOCK_REUSEPORT_OPTION SO_REUSEPORT_LB
+#elif defined(SO_REUSEPORT)
+#define TEOSOCK_REUSEPORT_OPTION SO_REUSEPORT
+#endif
+
+// Attach classic BPF program selecting socket with index equal to CPU number modulo group size.
+static int teosockAttachReuseportCpuProgram(teonetSocket socket_descriptor, size_t sockets_count) {
+#if defined(TEONET_OS_LINUX)
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)sockets_count},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+
+    struct sock_fprog program;
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+
+    return setsockopt(socket_descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program));
+#else
+    return TEOSOCK_SOCKET_ERROR;
+#endif
+}
+
+// Creates one socket of a reuseport group and binds it to the address.
+static teonetSocket teosockCreateReuseportSocket(
+    teosockSocketType type, teosockResolvedAddress* address, teosockReuseportSteering steering, size_t index,
+    size_t sockets_count) {
+    bool is_udp = type == TEOSOCK_SOCKET_TYPE_UDP;
+    teonetSocket socket_descriptor =
+        socket(address->family, is_udp ? SOCK_DGRAM : SOCK_STREAM, is_udp ? IPPROTO_UDP : IPPROTO_TCP);
+
+    if (socket_descriptor == TEOSOCK_INVALID_SOCKET) {
+        return TEOSOCK_INVALID_SOCKET;
+    }
+
+    int enable = 1;
+    int result = 0;
+
+    if (!is_udp) {
+        result = setsockopt(socket_descriptor, SOL_SOCKET, SO_REUSEADDR, (const char*)&enable, sizeof(enable));
+    }
+
+#if defined(TEOSOCK_REUSEPORT_OPTION)
+    if (result == 0 && sockets_count > 1) {
+        result = setsockopt(socket_descriptor, SOL_SOCKET, TEOSOCK_REUSEPORT_OPTION, &enable, sizeof(enable));
+    }
+#endif
+
+#if defined(TEONET_OS_LINUX)
+    if (result == 0 && steering == TEOSOCK_REUSEPORT_STEERING_INCOMING_CPU) {
+        int cpu = (int)index;
+        result = setsockopt(socket_descriptor, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+    }
+#endif
+
+    if (result == 0) {
+        result = bind(socket_descriptor, (const struct sockaddr*)&address->address, address->address_length);
+    }
+
+    // Program is attached to the first socket, it applies to the whole group.
+    if (result == 0 && index == 0 && steering == TEOSOCK_REUSEPORT_STEERING_CPU_BPF) {
+        result = teosockAttachReuseportCpuProgram(socket_descriptor, sockets_count);
+    }
+
+    if (result == 0 && !is_udp) {
+        result = listen(socket_descriptor, SOMAXCONN);
+    }
+
+    if (result != 0) {
+        teosockClose(socket_descriptor);
+        return TEOSOCK_INVALID_SOCKET;
+    }
+
+    return socket_descriptor;
+}
+
+// Creates a group of sockets bound to the same address and port.
+int teosockCreateReuseportGroup(
+    teosockSocketType type, const char* address, uint16_t port, teosockReuseportSteering steering,
+    teonetSocket* sockets, size_t sockets_count) {
+    if (sockets_count == 0 || sockets_count > TEOSOCK_REUSEPORT_MAX_SOCKETS) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+#if !defined(TEOSOCK_REUSEPORT_OPTION)
+    if (sockets_count > 1) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+#endif
+
+#if !defined(TEONET_OS_LINUX)
+    if (steering != TEOSOCK_REUSEPORT_STEERING_HASH) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+#endif
+
+    teosockResolvedAddress bind_address;
+
+    if (address != NULL) {
+        teosockResolvedAddresses resolved;
+        if (teosockResolve(address, port, &resolved) != TEOSOCK_RESOLVE_SUCCESS || resolved.count == 0) {
+            return TEOSOCK_SOCKET_ERROR;
+        }
+
+        bind_address = resolved.addresses[0];
+    } else {
+        struct sockaddr_in any_address;
+        memset(&any_address, 0, sizeof(any_address));
+        any_address.sin_family = AF_INET;
+        any_address.sin_addr.s_addr = htonl(INADDR_ANY);
+        any_address.sin_port = htons(port);
+
+        memset(&bind_address, 0, sizeof(bind_address));
+        memcpy(&bind_address.address, &any_address, sizeof(any_address));
+        bind_address.address_length = sizeof(any_address);
+        bind_address.family = AF_INET;
+    }
+
+    for (size_t i = 0; i < sockets_count; ++i) {
+        sockets[i] = teosockCreateReuseportSocket(type, &bind_address, steering, i, sockets_count);
+
+        if (sockets[i] == TEOSOCK_INVALID_SOCKET) {
+            for (size_t j = 0; j < i; ++j) {
+                teosockClose(sockets[j]);
+                sockets[j] = TEOSOCK_INVALID_SOCKET;
+            }
+
+            return TEOSOCK_SOCKET_ERROR;
+        }
+
+        // With zero port the first socket gets ephemeral port, the rest join it.
+        if (i == 0 && port == 0) {
+            socklen_t address_length = sizeof(bind_address.address);
+            if (getsockname(sockets[0], (struct sockaddr*)&bind_address.address, &address_length) != 0) {
+                teosockClose(sockets[0]);
+                sockets[0] = TEOSOCK_INVALID_SOCKET;
+                return TEOSOCK_SOCKET_ERROR;
+            }
+        }
+    }
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+#if !defined(TEONET_OS_WINDOWS)
+// Fill AF_UNIX address. Leading '@' selects Linux abstract namespace.
+static bool teosockUnixAddress(const char* path, struct sockaddr_un* address, socklen_t* address_length) {
+    size_t path_length = strlen(path);
+
+    if (path_length == 0 || path_length >= sizeof(address->sun_path)) {
+        return false;
+    }
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    memcpy(address->sun_path, path, path_length);
+
+#if defined(TEONET_OS_LINUX)
+    if (path[0] == '@') {
+        // Abstract name is not null-terminated, its length is given by address length.
+        address->sun_path[0] = '\0';
+        *address_length = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + path_length);
+        return true;
+    }
+#endif
+
+    *address_length = (socklen_t)sizeof(*address);
+    return true;
+}
+
+// Convert teosockUnixType to socket type.
+static int teosockUnixSocketType(teosockUnixType type) {
+    return type == TEOSOCK_UNIX_DATAGRAM ? SOCK_DGRAM : SOCK_STREAM;
+}
+#endif
+
+// Creates a Unix domain socket.
+teonetSocket teosockCreateUnix(teosockUnixType type) {
+#if defined(TEONET_OS_WINDOWS)
+    return TEOSOCK_INVALID_SOCKET;
+#else
+    return socket(AF_UNIX, teosockUnixSocketType(type), 0);
+#endif
+}
+
+// Binds a Unix domain socket to a path.
+int teosockBindUnix(teonetSocket socket_descriptor, const char* path) {
+#if !defined(TEONET_OS_WINDOWS)
+    struct sockaddr_un address;
+    socklen_t address_length;
+
+    if (teosockUnixAddress(path, &address, &address_length) &&
+        bind(socket_descriptor, (struct sockaddr*)&address, address_length) == 0) {
+        return TEOSOCK_SOCKET_SUCCESS;
+    }
+#endif
+
+    return TEOSOCK_SOCKET_ERROR;
+}
+
+// Connects a Unix domain socket to a path.
+teosockConnectResult teosockConnectUnix(teonetSocket socket_descriptor, const char* path) {
+#if defined(TEONET_OS_WINDOWS)
+    return TEOSOCK_CONNECT_FAILED;
+#else
+    struct sockaddr_un address;
+    socklen_t address_length;
+
+    if (!teosockUnixAddress(path, &address, &address_length)) {
+        return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+    }
+
+    int connect_result = connect(socket_descriptor, (struct sockaddr*)&address, address_length);
+    if (connect_result != 0 && errno != EINPROGRESS) {
+        return TEOSOCK_CONNECT_FAILED;
+    }
+
+    return TEOSOCK_CONNECT_SUCCESS;
+#endif
+}
+
+// Creates a pair of connected Unix domain sockets.
+int teosockCreateUnixPair(teosockUnixType type, teonetSocket sockets[2]) {
+#if !defined(TEONET_OS_WINDOWS)
+    int descriptors[2];
+
+    if (socketpair(AF_UNIX, teosockUnixSocketType(type), 0, descriptors) == 0) {
+        sockets[0] = descriptors[0];
+        sockets[1] = descriptors[1];
+        return TEOSOCK_SOCKET_SUCCESS;
+    }
+#endif
+
+    return TEOSOCK_SOCKET_ERROR;
+}
+
+// Sends data together with file descriptors over a Unix domain socket.
+ssize_t teosockSendDescriptors(teonetSocket socket_descriptor, const uint8_t* data, size_t length,
+    const int* descriptors, size_t descriptors_count) {
+#if defined(TEONET_OS_WINDOWS)
+    return TEOSOCK_SOCKET_ERROR;
+#else
+    if (length == 0 || descriptors_count > TEOSOCK_UNIX_MAX_DESCRIPTORS) {
+        errno = EINVAL;
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    struct iovec vector;
+    vector.iov_base = (void*)data;
+    vector.iov_len = length;
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * TEOSOCK_UNIX_MAX_DESCRIPTORS)];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+
+    if (descriptors_count != 0) {
+        header.msg_control = control.buffer;
+        header.msg_controllen = CMSG_SPACE(sizeof(int) * descriptors_count);
+
+        struct cmsghdr* control_message = CMSG_FIRSTHDR(&header);
+        control_message->cmsg_level = SOL_SOCKET;
+        control_message->cmsg_type = SCM_RIGHTS;
+        control_message->cmsg_len = CMSG_LEN(sizeof(int) * descriptors_count);
+        memcpy(CMSG_DATA(control_message), descriptors, sizeof(int) * descriptors_count);
+    }
+
+    return sendmsg(socket_descriptor, &header, 0);
+#endif
+}
+
+// Receives data together with file descriptors over a Unix domain socket.
+ssize_t teosockRecvDescriptors(teonetSocket socket_descriptor, uint8_t* data, size_t length,
+    int* descriptors, size_t max_descriptors, size_t* descriptors_count) {
+    *descriptors_count = 0;
+
+#if defined(TEONET_OS_WINDOWS)
+    return TEOSOCK_SOCKET_ERROR;
+#else
+    struct iovec vector;
+    vector.iov_base = data;
+    vector.iov_len = length;
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * TEOSOCK_UNIX_MAX_DESCRIPTORS)];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+    int flags = 0;
+#if defined(MSG_CMSG_CLOEXEC)
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+    ssize_t received = recvmsg(socket_descriptor, &header, flags);
+    if (received < 0) {
+        return received;
+    }
+
+    for (struct cmsghdr* control_message = CMSG_FIRSTHDR(&header); control_message != NULL;
+         control_message = CMSG_NXTHDR(&header, control_message)) {
+        if (control_message->cmsg_level != SOL_SOCKET || control_message->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+
+        size_t count = (control_message->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int* received_descriptors = (int*)CMSG_DATA(control_message);
+
+        for (size_t i = 0; i < count; ++i) {
+            int descriptor;
+            memcpy(&descriptor, &received_descriptors[i], sizeof(descriptor));
+
+            // Descriptors which do not fit are closed, otherwise they would leak.
+            if (*descriptors_count < max_descriptors) {
+                descriptors[(*descriptors_count)++] = descriptor;
+            } else {
+                close(descriptor);
+            }
+        }
+    }
+
+    return received;
+#endif
+}
+
+// Resolve server to IPv4 address, the only family supported by socket created by teosockCreateTcp().
+static bool teosockResolveIpv4(const char* server, uint16_t port, struct sockaddr_in* serveraddr) {
+    teosockResolvedAddresses resolved;
+
+    // Resolve host address if needed.
+    if (teosockResolve(server, port, &resolved) != TEOSOCK_RESOLVE_SUCCESS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < resolved.count; ++i) {
+        if (resolved.addresses[i].family == AF_INET) {
+            memcpy(serveraddr, &resolved.addresses[i].address, sizeof(*serveraddr));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Establishes a connection to a specified server.
+teosockConnectResult teosockConnect(teonetSocket socket_descriptor, const char* server, uint16_t port) {
+    struct sockaddr_in serveraddr;
+
+    if (!teosockResolveIpv4(server, port, &serveraddr)) {
+        return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+    }
+
+    // Connect to server.
+    int connect_result = connect(socket_descriptor, (struct sockaddr*)&serveraddr, sizeof(serveraddr));
+    if (connect_result != 0 && errno != EINPROGRESS) {
+        return TEOSOCK_CONNECT_FAILED;
+    }
+
+    return TEOSOCK_CONNECT_SUCCESS;
+}
+
+// Gets error code of the last failed socket function.
+int teosockGetLastError(void) {
+#if defined(TEONET_OS_WINDOWS)
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+// Establishes a connection sending first data in SYN packet using TCP Fast Open.
+teosockConnectResult teosockConnectFastOpen(teonetSocket socket_descriptor, const char* server, uint16_t port,
+    const uint8_t* data, size_t length, size_t* sent_length) {
+    struct sockaddr_in serveraddr;
+
+    *sent_length = 0;
+
+    if (!teosockResolveIpv4(server, port, &serveraddr)) {
+        return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+    }
+
+#if defined(MSG_FASTOPEN)
+    ssize_t sent = sendto(socket_descriptor, data, length, MSG_FASTOPEN,
+        (struct sockaddr*)&serveraddr, sizeof(serveraddr));
+
+    if (sent >= 0) {
+        *sent_length = (size_t)sent;
+        return TEOSOCK_CONNECT_SUCCESS;
+    }
+
+    // No cookie yet: SYN requesting cookie was sent without data, send data after connection.
+    if (errno == EINPROGRESS) {
+        return TEOSOCK_CONNECT_SUCCESS;
+    }
+
+    // Fast Open is disabled, connect normally.
+    if (errno != EOPNOTSUPP) {
+        return TEOSOCK_CONNECT_FAILED;
+    }
+#endif
+
+    int connect_result = connect(socket_descriptor, (struct sockaddr*)&serveraddr, sizeof(serveraddr));
+    if (connect_result != 0 && errno != EINPROGRESS) {
+        return TEOSOCK_CONNECT_FAILED;
+    }
+
+    return TEOSOCK_CONNECT_SUCCESS;
+}
+
+// Enables TCP Fast Open for teosockConnect() on a socket.
+int teosockSetFastOpenConnect(teonetSocket socket_descriptor) {
+#if defined(TEONET_OS_LINUX)
+    int enable = 1;
+
+    if (setsockopt(socket_descriptor, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &enable, sizeof(enable)) == 0) {
+        return TEOSOCK_SOCKET_SUCCESS;
+    }
+#endif
+
+    return TEOSOCK_SOCKET_ERROR;
+}
+
+// Enables accepting TCP Fast Open connections on a listening socket.
+int teosockSetFastOpenListen(teonetSocket socket_descriptor, int queue_length) {
+#if defined(TCP_FASTOPEN)
+    if (setsockopt(socket_descriptor, IPPROTO_TCP, TCP_FASTOPEN, (const char*)&queue_length, sizeof(queue_length)) ==
+        0) {
+        return TEOSOCK_SOCKET_SUCCESS;
+    }
+#endif
+
+    return TEOSOCK_SOCKET_ERROR;
+}
+
+// Establishes a connection to a specified server.
+teosockConnectResult teosockConnectTimeout(teonetSocket* socket_descriptor, const char* server, uint16_t port, int timeout_ms) {
+    return teosockConnectParallel(socket_descriptor, server, port, timeout_ms, TEOSOCK_CONNECT_ATTEMPT_DELAY_MS);
+}
+
+#if defined(TEONET_OS_WINDOWS)
+typedef WSAPOLLFD teosockPollfd;
+#else
+typedef struct pollfd teosockPollfd;
+#endif
+
+// Interval of checking background host resolution by asynchronous connection, in milliseconds.
+#define TEOSOCK_CONNECT_RESOLVE_CHECK_MS 10
+
+// Stage of the connection state machine.
+typedef enum teosockConnectStage {
+    TEOSOCK_CONNECT_STAGE_RESOLVING,
+    TEOSOCK_CONNECT_STAGE_CONNECTING,
+    TEOSOCK_CONNECT_STAGE_DONE,
+} teosockConnectStage;
+
+// Connection state machine shared by teosockConnectParallel() and teosockConnectAsync().
+typedef struct teosockConnectState {
+    teosockConnectStage stage;
+    teosockConnectResult result;
+
+    char* server;
+    uint16_t port;
+
+    teosockResolvedAddresses resolved;
+    const teosockResolvedAddress* addresses[TEOSOCK_RESOLVER_MAX_ADDRESSES];
+    size_t addresses_count;
+    size_t next_address;
+
+    teosockPollfd attempts[TEOSOCK_CONNECT_MAX_ATTEMPTS];
+    size_t attempts_count;
+
+    teonetSocket connected_socket;
+
+    int attempt_delay_ms;
+    int64_t deadline_ms;
+    int64_t next_attempt_time_ms;
+} teosockConnectState;
+
+struct teosockAsyncConnect {
+    teosockConnectState state;
+};
+
+// Order resolved addresses alternating address families, as described in RFC 8305 section 4.
+static size_t teosockConnectOrderAddresses(const teosockResolvedAddresses* resolved, const teosockResolvedAddress** ordered) {
+    const teosockResolvedAddress* primary[TEOSOCK_RESOLVER_MAX_ADDRESSES];
+    const teosockResolvedAddress* secondary[TEOSOCK_RESOLVER_MAX_ADDRESSES];
+    size_t primary_count = 0;
+    size_t secondary_count = 0;
+
+    // Family of the first address is preferred by the resolver.
+    int primary_family = resolved->count != 0 ? resolved->addresses[0].family : AF_UNSPEC;
+
+    for (size_t i = 0; i < resolved->count; ++i) {
+        if (resolved->addresses[i].family == primary_family) {
+            primary[primary_count++] = &resolved->addresses[i];
+        } else {
+            secondary[secondary_count++] = &resolved->addresses[i];
+        }
+    }
+
+    size_t count = 0;
+    size_t primary_index = 0;
+    size_t secondary_index = 0;
+
+    while (primary_index < primary_count || secondary_index < secondary_count) {
+        if (primary_index < primary_count) {
+            ordered[count++] = primary[primary_index++];
+        }
+
+        if (secondary_index < secondary_count) {
+            ordered[count++] = secondary[secondary_index++];
+        }
+    }
+
+    return count;
+}
+
+// Starts non-blocking connection attempt. Returns socket or TEOSOCK_INVALID_SOCKET if attempt failed immediately.
+static teonetSocket teosockConnectStartAttempt(const teosockResolvedAddress* address, bool* connected) {
+    *connected = false;
+
+    teonetSocket attempt_socket = socket(address->family, SOCK_STREAM, IPPROTO_TCP);
+    if (attempt_socket == TEOSOCK_INVALID_SOCKET) {
+        return TEOSOCK_INVALID_SOCKET;
+    }
+
+    if (teosockSetBlockingMode(attempt_socket, TEOSOCK_NON_BLOCKING_MODE) == TEOSOCK_SOCKET_ERROR) {
+        teosockClose(attempt_socket);
+        return TEOSOCK_INVALID_SOCKET;
+    }
+
+    if (connect(attempt_socket, (const struct sockaddr*)&address->address, address->address_length) == 0) {
+        *connected = true;
+        return attempt_socket;
+    }
+
+    int error_code = teosockGetLastError();
+
+#if defined(TEONET_OS_WINDOWS)
+    bool in_progress = error_code == WSAEWOULDBLOCK;
+#else
+    bool in_progress = error_code == EINPROGRESS;
+#endif
+
+    if (!in_progress) {
+        teosockClose(attempt_socket);
+        return TEOSOCK_INVALID_SOCKET;
+    }
+
+    return attempt_socket;
+}
+
+// Initialize connection state machine. Server name is not copied.
+static void teosockConnectStateInit(
+    teosockConnectState* state, char* server, uint16_t port, int timeout_ms, int attempt_delay_ms) {
+    memset(state, 0, sizeof(*state));
+
+    state->stage = TEOSOCK_CONNECT_STAGE_RESOLVING;
+    state->result = TEOSOCK_CONNECT_PENDING;
+    state->server = server;
+    state->port = port;
+    state->connected_socket = TEOSOCK_INVALID_SOCKET;
+    state->attempt_delay_ms = attempt_delay_ms;
+    state->deadline_ms = teotimeGetMonotonicMs() + timeout_ms;
+}
+
+// Set addresses to connect to and move state machine to connecting stage.
+static void teosockConnectStateSetResolved(teosockConnectState* state, int64_t now_ms) {
+    state->addresses_count = teosockConnectOrderAddresses(&state->resolved, state->addresses);
+    state->next_address = 0;
+    state->next_attempt_time_ms = now_ms;
+    state->stage = TEOSOCK_CONNECT_STAGE_CONNECTING;
+}
+
+// Close all attempts in flight and finish state machine with specified result.
+static teosockConnectResult teosockConnectStateFinish(teosockConnectState* state, teosockConnectResult result) {
+    for (size_t i = 0; i < state->attempts_count; ++i) {
+        teosockClose(state->attempts[i].fd);
+    }
+
+    state->attempts_count = 0;
+    state->stage = TEOSOCK_CONNECT_STAGE_DONE;
+    state->result = result;
+
+    return result;
+}
+
+// Check whether next connection attempt may be started.
+static bool teosockConnectStateCanStartAttempt(const teosockConnectState* state) {
+    return state->next_address < state->addresses_count && state->attempts_count < TEOSOCK_CONNECT_MAX_ATTEMPTS;
+}
+
+// Advance connection state machine without blocking.
+// If revents_ready is set, attempts[].revents were filled by caller's poll, otherwise they are polled here.
+static teosockConnectResult teosockConnectStateStep(teosockConnectState* state, bool revents_ready) {
+    if (state->stage == TEOSOCK_CONNECT_STAGE_DONE) {
+        return state->result;
+    }
+
+    int64_t now_ms = teotimeGetMonotonicMs();
+
+    if (state->stage == TEOSOCK_CONNECT_STAGE_RESOLVING) {
+        teosockResolveResult resolve_result = teosockResolveNonBlocking(state->server, state->port, &state->resolved);
+
+        if (resolve_result == TEOSOCK_RESOLVE_NOT_FOUND) {
+            return teosockConnectStateFinish(state, TEOSOCK_CONNECT_HOST_NOT_FOUND);
+        }
+
+        if (resolve_result == TEOSOCK_RESOLVE_PENDING) {
+            if (now_ms >= state->deadline_ms) {
+                return teosockConnectStateFinish(state, TEOSOCK_CONNECT_HOST_NOT_FOUND);
+            }
+
+            return TEOSOCK_CONNECT_PENDING;
+        }
+
+        teosockConnectStateSetResolved(state, now_ms);
+        revents_ready = false;
+    }
+
+    if (!revents_ready && state->attempts_count != 0) {
+#if defined(TEONET_OS_WINDOWS)
+        int poll_result = WSAPoll(state->attempts, (ULONG)state->attempts_count, 0);
+#else
+        int poll_result = poll(state->attempts, (nfds_t)state->attempts_count, 0);
+#endif
+
+        if (poll_result < 0) {
+            // Check results on next step.
+            for (size_t i = 0; i < state->attempts_count; ++i) {
+                state->attempts[i].revents = 0;
+            }
+        }
+    }
+
+    // Check SO_ERROR of attempts which became writable or failed.
+    for (size_t i = 0; i < state->attempts_count;) {
+        if (state->attempts[i].revents == 0) {
+            ++i;
+            continue;
+        }
+
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        int getsockopt_result = getsockopt(state->attempts[i].fd, SOL_SOCKET, SO_ERROR, (char*)&error, &error_len);
+
+        if (getsockopt_result != TEOSOCK_SOCKET_ERROR && error == 0 && (state->attempts[i].revents & POLLOUT)) {
+            state->connected_socket = state->attempts[i].fd;
+            state->attempts[i] = state->attempts[--state->attempts_count];
+            return teosockConnectStateFinish(state, TEOSOCK_CONNECT_SUCCESS);
+        }
+
+        // Attempt failed, close it and let next address start without waiting.
+        teosockClose(state->attempts[i].fd);
+        state->attempts[i] = state->attempts[--state->attempts_count];
+        state->next_attempt_time_ms = now_ms;
+    }
+
+    if (now_ms >= state->deadline_ms) {
+        return teosockConnectStateFinish(state, TEOSOCK_CONNECT_FAILED);
+    }
+
+    // Start next attempts when their delay passed or when nothing else is in flight.
+    while (teosockConnectStateCanStartAttempt(state) &&
+           (now_ms >= state->next_attempt_time_ms || state->attempts_count == 0)) {
+        bool connected = false;
+        teonetSocket attempt_socket = teosockConnectStartAttempt(state->addresses[state->next_address], &connected);
+        ++state->next_address;
+
+        if (connected) {
+            state->connected_socket = attempt_socket;
+            return teosockConnectStateFinish(state, TEOSOCK_CONNECT_SUCCESS);
+        }
+
+        if (attempt_socket != TEOSOCK_INVALID_SOCKET) {
+            teosockPollfd* attempt = &state->attempts[state->attempts_count++];
+            memset(attempt, 0, sizeof(*attempt));
+            attempt->fd = attempt_socket;
+            attempt->events = POLLOUT;
+
+            state->next_attempt_time_ms = now_ms + state->attempt_delay_ms;
+        } else {
+            // Immediate failure, do not wait before trying next address.
+            state->next_attempt_time_ms = now_ms;
+        }
+    }
+
+    if (state->attempts_count == 0) {
+        // All addresses failed.
+        return teosockConnectStateFinish(state, TEOSOCK_CONNECT_FAILED);
+    }
+
+    return TEOSOCK_CONNECT_PENDING;
+}
+
+// Get time until state machine needs next step if no socket becomes ready, in milliseconds.
+static int teosockConnectStateGetTimeout(const teosockConnectState* state) {
+    if (state->stage == TEOSOCK_CONNECT_STAGE_DONE) {
+        return 0;
+    }
+
+    int64_t now_ms = teotimeGetMonotonicMs();
+    int64_t wait_ms = state->deadline_ms - now_ms;
+
+    if (state->stage == TEOSOCK_CONNECT_STAGE_RESOLVING) {
+        if (wait_ms > TEOSOCK_CONNECT_RESOLVE_CHECK_MS) {
+            wait_ms = TEOSOCK_CONNECT_RESOLVE_CHECK_MS;
+        }
+    } else if (teosockConnectStateCanStartAttempt(state) && state->next_attempt_time_ms - now_ms < wait_ms) {
+        wait_ms = state->next_attempt_time_ms - now_ms;
+    }
+
+    if (wait_ms < 0) {
+        wait_ms = 0;
+    }
+
+    return (int)wait_ms;
+}
+
+// Establishes a connection trying several server addresses concurrently.
+teosockConnectResult teosockConnectParallel(
+    teonetSocket* socket_descriptor, const char* server, uint16_t port, int timeout_ms, int attempt_delay_ms) {
+    teosockConnectState state;
+    teosockConnectStateInit(&state, (char*)server, port, timeout_ms, attempt_delay_ms);
+
+    // Caller agreed to block, so resolve host here instead of checking background resolution.
+    if (teosockResolve(server, port, &state.resolved) != TEOSOCK_RESOLVE_SUCCESS) {
+        return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+    }
+
+    teosockConnectStateSetResolved(&state, teotimeGetMonotonicMs());
+
+    bool revents_ready = false;
+    teosockConnectResult result;
+
+    while ((result = teosockConnectStateStep(&state, revents_ready)) == TEOSOCK_CONNECT_PENDING) {
+        int wait_ms = teosockConnectStateGetTimeout(&state);
+
+#if defined(TEONET_OS_WINDOWS)
+        int poll_result = WSAPoll(state.attempts, (ULONG)state.attempts_count, (INT)wait_ms);
+#else
+        int poll_result = poll(state.attempts, (nfds_t)state.attempts_count, wait_ms);
+#endif
+
+        if (poll_result < 0) {
+#if !defined(TEONET_OS_WINDOWS)
+            if (errno == EINTR) {
+                revents_ready = false;
+                continue;
+            }
+#endif
+            result = teosockConnectStateFinish(&state, TEOSOCK_CONNECT_FAILED);
+            break;
+        }
+
+        revents_ready = true;
+    }
+
+    if (result == TEOSOCK_CONNECT_SUCCESS) {
+        *socket_descriptor = state.connected_socket;
+    }
+
+    return result;
+}
+
+// Starts asynchronous connection to a specified server.
+teosockAsyncConnect* teosockConnectAsync(const char* server, uint16_t port, int timeout_ms, int attempt_delay_ms) {
+    teosockAsyncConnect* async_connect = malloc(sizeof(teosockAsyncConnect));
+    if (async_connect == NULL) {
+        return NULL;
+    }
+
+    size_t server_length = strlen(server);
+    char* server_copy = malloc(server_length + 1);
+    if (server_copy == NULL) {
+        free(async_connect);
+        return NULL;
+    }
+
+    memcpy(server_copy, server, server_length + 1);
+
+    teosockConnectStateInit(&async_connect->state, server_copy, port, timeout_ms, attempt_delay_ms);
+
+    // Start resolution and first attempt right away, result is reported by teosockConnectAsyncProcess().
+    teosockConnectStateStep(&async_connect->state, false);
+
+    return async_connect;
+}
+
+// Advances asynchronous connection.
+teosockConnectResult teosockConnectAsyncProcess(teosockAsyncConnect* async_connect, teonetSocket* socket_descriptor) {
+    teosockConnectResult result = teosockConnectStateStep(&async_connect->state, false);
+
+    if (result == TEOSOCK_CONNECT_SUCCESS) {
+        *socket_descriptor = async_connect->state.connected_socket;
+    }
+
+    return result;
+}
+
+// Gets sockets of connection attempts in flight.
+size_t teosockConnectAsyncGetSockets(
+    const teosockAsyncConnect* async_connect, teonetSocket* sockets, size_t max_sockets) {
+    size_t count = async_connect->state.attempts_count;
+    if (count > max_sockets) {
+        count = max_sockets;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        sockets[i] = async_connect->state.attempts[i].fd;
+    }
+
+    return count;
+}
+
+// Gets time until asynchronous connection must be advanced.
+int teosockConnectAsyncGetTimeout(const teosockAsyncConnect* async_connect) {
+    return teosockConnectStateGetTimeout(&async_connect->state);
+}
+
+// Cancels asynchronous connection and frees its resources.
+void teosockConnectAsyncDestroy(teosockAsyncConnect* async_connect) {
+    if (async_connect == NULL) {
+        return;
+    }
+
+    if (async_connect->state.stage != TEOSOCK_CONNECT_STAGE_DONE) {
+        teosockConnectStateFinish(&async_connect->state, TEOSOCK_CONNECT_FAILED);
+    }
+
+    free(async_connect->state.server);
+    free(async_connect);
+}
+
+// Checks if socket error code means that operation would block and can be retried later.
+bool teosockRecvfromErrorIsRecoverable(int error_code) {
+#if defined(TEONET_OS_WINDOWS)
+    return error_code == WSAEWOULDBLOCK;
+#else
+    // EWOULDBLOCK may be not defined or may have same value as EAGAIN.
+#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
+    return error_code == EAGAIN || error_code == EWOULDBLOCK;
+#else
+    return error_code == EAGAIN;
+#endif
+#endif
+}
+
+// Check if error code from recvfrom is fatal socket error.
+static bool teosockRecvfromErrorIsFatal(int error_code) {
+#if defined(TEONET_OS_WINDOWS)
+    return error_code == WSAEFAULT || error_code == WSAEINVAL ||
+           error_code == WSAENOTSOCK || error_code == WSAESHUTDOWN;
+#else
+    return error_code == ENOTCONN || error_code == EBADF;
+#endif
+}
+
+// Convert error code from recvfrom to teosockRecvfromResult value.
+static teosockRecvfromResult teosockRecvfromErrorToResult(int error_code) {
+    if (teosockRecvfromErrorIsRecoverable(error_code)) {
+        return TEOSOCK_RECVFROM_TRY_AGAIN;
+    } else if (teosockRecvfromErrorIsFatal(error_code)) {
+        return TEOSOCK_RECVFROM_FATAL_ERROR;
+    } else {
+        return TEOSOCK_RECVFROM_UNKNOWN_ERROR;
+    }
+}
+
+// Check if error code from send functions makes the socket unusable for any further message.
+static bool teosockSendErrorIsFatal(int error_code) {
+#if defined(TEONET_OS_WINDOWS)
+    return error_code == WSAENOTSOCK || error_code == WSAESHUTDOWN ||
+           error_code == WSAENETDOWN || error_code == WSANOTINITIALISED;
+#else
+    return error_code == EBADF || error_code == ENOTSOCK || error_code == EPIPE;
+#endif
+}
+
+#if defined(_MSC_VER)
+#define TEOSOCK_THREAD_LOCAL __declspec(thread)
+#else
+#define TEOSOCK_THREAD_LOCAL __thread
+#endif
+
+// Statistics are collected only when enabled, disabled check costs one branch per call.
+static bool teosockStatsEnabled = false;
+
+// Statistics of the calling thread, no synchronization needed.
+static TEOSOCK_THREAD_LOCAL teosockStats teosockThreadStats;
+
+// Count failed socket call by error class.
+static void teosockStatsCountError(int error_code, bool is_fatal) {
+    if (teosockRecvfromErrorIsRecoverable(error_code)) {
+        ++teosockThreadStats.would_block;
+    } else if (is_fatal) {
+        ++teosockThreadStats.fatal_errors;
+    } else {
+        ++teosockThreadStats.other_errors;
+    }
+}
+
+// Count result of receive call. Must be called right after the call, before errno changes.
+static void teosockStatsCountRecv(ssize_t result) {
+    ++teosockThreadStats.recv_calls;
+
+    if (result > 0) {
+        teosockThreadStats.recv_bytes += (uint64_t)result;
+    } else if (result == 0) {
+        ++teosockThreadStats.orderly_closes;
+    } else {
+        int error_code = teosockGetLastError();
+        teosockStatsCountError(error_code, teosockRecvfromErrorIsFatal(error_code));
+    }
+}
+
+// Count result of send call. Must be called right after the call, before errno changes.
+static void teosockStatsCountSend(ssize_t result, size_t length) {
+    ++teosockThreadStats.send_calls;
+
+    if (result >= 0) {
+        teosockThreadStats.send_bytes += (uint64_t)result;
+
+        if ((size_t)result < length) {
+            ++teosockThreadStats.short_writes;
+        }
+    } else {
+        int error_code = teosockGetLastError();
+        teosockStatsCountError(error_code, teosockSendErrorIsFatal(error_code));
+    }
+}
+
+#if defined(TEONET_OS_LINUX)
+// Count result of send call which was split into datagrams by the kernel, one send per datagram.
+// Must be called right after the call, before errno changes.
+static void teosockStatsCountSendSegments(ssize_t result, size_t length, size_t segment_size) {
+    if (result < 0) {
+        teosockStatsCountSend(result, length);
+        return;
+    }
+
+    for (size_t offset = 0; offset < length; offset += segment_size) {
+        size_t segment_length = length - offset < segment_size ? length - offset : segment_size;
+        size_t segment_sent = (size_t)result > offset ? (size_t)result - offset : 0;
+
+        teosockStatsCountSend((ssize_t)(segment_sent < segment_length ? segment_sent : segment_length), segment_length);
+    }
+}
+#endif
+
+// Get total length of buffers.
+static size_t teosockIovecLength(const teosockIovec* iov, size_t iov_count) {
+    size_t length = 0;
+
+    for (size_t i = 0; i < iov_count; ++i) {
+        length += iov[i].length;
+    }
+
+    return length;
+}
+
+// Enables or disables collection of socket statistics.
+void teosockStatsSetEnabled(bool enabled) {
+    teosockStatsEnabled = enabled;
+}
+
+// Gets socket statistics of the calling thread.
+void teosockStatsGet(teosockStats* stats) {
+    *stats = teosockThreadStats;
+}
+
+// Resets socket statistics of the calling thread.
+void teosockStatsReset(void) {
+    memset(&teosockThreadStats, 0, sizeof(teosockThreadStats));
+}
+
+// Receives data from a connected socket.
+ssize_t teosockRecv(teonetSocket socket_descriptor, uint8_t* data, size_t length) {
+#if defined(TEONET_OS_WINDOWS)
+    if (length > (ssize_t)INT_MAX) {
+        // Can't receive this much data.
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    ssize_t result = recv(socket_descriptor, (char*)data, (int)length, 0);
+#else
+    ssize_t result = read(socket_descriptor, data, length);
+#endif
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountRecv(result);
+    }
+
+    return result;
+}
+
+// Receives data from a connection-mode or connectionless-mode socket.
+teosockRecvfromResult teosockRecvfrom(
+    teonetSocket socket_descriptor, uint8_t* buffer, size_t buffer_size,
+    struct sockaddr* __restrict address, socklen_t* address_length,
+    size_t* received_length, int* error_code) {
+    teosockRecvfromResult udp_recvfrom_result = TEOSOCK_RECVFROM_UNKNOWN_ERROR;
+    int flags = 0;
+
+#if defined(TEONET_OS_WINDOWS)
+    if (buffer_size > (size_t)INT_MAX) {
+        buffer_size = (size_t)INT_MAX;
+    }
+    ssize_t recvlen =
+        recvfrom(socket_descriptor, buffer, (int)buffer_size, flags, address, address_length);
+#else
+    ssize_t recvlen =
+        recvfrom(socket_descriptor, buffer, buffer_size, flags, address, address_length);
+#endif
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountRecv(recvlen);
+    }
+
+    if (recvlen == -1) {
+        int recv_errno = teosockGetLastError();
+
+        if (error_code != NULL) {
+            *error_code = recv_errno;
+        }
+
+        udp_recvfrom_result = teosockRecvfromErrorToResult(recv_errno);
+    } else if (recvlen == 0) {
+        udp_recvfrom_result = TEOSOCK_RECVFROM_ORDERLY_CLOSED;
+    } else {
+        if (received_length != NULL) {
+            *received_length = (size_t)recvlen;
+        }
+
+        udp_recvfrom_result = TEOSOCK_RECVFROM_DATA_RECEIVED;
+    }
+
+    return udp_recvfrom_result;
+}
+
+#if defined(TEONET_OS_LINUX)
+// Maximum amount of datagrams received by one recvmmsg() call.
+#define TEOSOCK_RECVFROM_BATCH_SIZE 64
+#endif
+
+// Receives several datagrams from a connectionless-mode socket in one call.
+teosockRecvfromResult teosockRecvfromBatch(
+    teonetSocket socket_descriptor, teosockRecvfromMessage* messages,
+    size_t messages_count, size_t* received_count, int* error_code) {
+    size_t total_count = 0;
+
+    if (received_count != NULL) {
+        *received_count = 0;
+    }
+
+    if (messages_count == 0) {
+        if (error_code != NULL) {
+#if defined(TEONET_OS_WINDOWS)
+            *error_code = WSAEINVAL;
+#else
+            *error_code = EINVAL;
+#endif
+        }
+
+        return TEOSOCK_RECVFROM_UNKNOWN_ERROR;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    struct mmsghdr headers[TEOSOCK_RECVFROM_BATCH_SIZE];
+    struct iovec vectors[TEOSOCK_RECVFROM_BATCH_SIZE];
+
+    while (total_count < messages_count) {
+        size_t batch_count = messages_count - total_count;
+        if (batch_count > TEOSOCK_RECVFROM_BATCH_SIZE) {
+            batch_count = TEOSOCK_RECVFROM_BATCH_SIZE;
+        }
+
+        teosockRecvfromMessage* batch = messages + total_count;
+        memset(headers, 0, sizeof(headers[0]) * batch_count);
+
+        for (size_t i = 0; i < batch_count; ++i) {
+            vectors[i].iov_base = batch[i].buffer;
+            vectors[i].iov_len = batch[i].buffer_size;
+
+            headers[i].msg_hdr.msg_name = &batch[i].address;
+            headers[i].msg_hdr.msg_namelen = sizeof(batch[i].address);
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        // Wait only for the first datagram, then take only what is already queued.
+        int flags = (total_count == 0) ? MSG_WAITFORONE : MSG_DONTWAIT;
+        int recv_count = recvmmsg(socket_descriptor, headers, (unsigned int)batch_count, flags, NULL);
+
+        if (teosockStatsEnabled) {
+            // Failure after some datagrams only ends the batch, it is not an error of the call.
+            if (recv_count == -1 && total_count == 0) {
+                teosockStatsCountRecv(-1);
+            }
+
+            for (int i = 0; i < recv_count; ++i) {
+                teosockStatsCountRecv((ssize_t)headers[i].msg_len);
+            }
+        }
+
+        if (recv_count == -1) {
+            if (total_count != 0) {
+                break;
+            }
+
+            int recv_errno = teosockGetLastError();
+
+            if (error_code != NULL) {
+                *error_code = recv_errno;
+            }
+
+            return teosockRecvfromErrorToResult(recv_errno);
+        }
+
+        for (int i = 0; i < recv_count; ++i) {
+            batch[i].address_length = headers[i].msg_hdr.msg_namelen;
+            batch[i].received_length = headers[i].msg_len;
+        }
+
+        total_count += (size_t)recv_count;
+
+        if ((size_t)recv_count < batch_count) {
+            break;
+        }
+    }
+#else
+    while (total_count < messages_count) {
+        // Do not block on the next datagram if something is already received.
+        if (total_count != 0 &&
+            teosockSelect(socket_descriptor, TEOSOCK_SELECT_MODE_READ, 0) != TEOSOCK_SELECT_READY) {
+            break;
+        }
+
+        teosockRecvfromMessage* message = &messages[total_count];
+        message->address_length = sizeof(message->address);
+
+        size_t received_length = 0;
+        int recv_errno = 0;
+
+        teosockRecvfromResult recvfrom_result = teosockRecvfrom(
+            socket_descriptor, message->buffer, message->buffer_size,
+            (struct sockaddr*)&message->address, &message->address_length,
+            &received_length, &recv_errno);
+
+        // Zero bytes from a datagram socket is an empty datagram, not end of stream, same as recvmmsg() reports it.
+        if (recvfrom_result == TEOSOCK_RECVFROM_ORDERLY_CLOSED) {
+            recvfrom_result = TEOSOCK_RECVFROM_DATA_RECEIVED;
+        }
+
+        if (recvfrom_result != TEOSOCK_RECVFROM_DATA_RECEIVED) {
+            if (total_count != 0) {
+                break;
+            }
+
+            if (error_code != NULL) {
+                *error_code = recv_errno;
+            }
+
+            return recvfrom_result;
+        }
+
+        message->received_length = received_length;
+        ++total_count;
+    }
+#endif
+
+    if (received_count != NULL) {
+        *received_count = total_count;
+    }
+
+    return TEOSOCK_RECVFROM_DATA_RECEIVED;
+}
+
+// Sends data on a connected socket.
+ssize_t teosockSend(teonetSocket socket_descriptor, const uint8_t* data, size_t length) {
+#if defined(TEONET_OS_WINDOWS)
+    if (length > (ssize_t)INT_MAX) {
+        // Can't send this much data.
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    ssize_t result = send(socket_descriptor, (const char*)data, (int)length, 0);
+#else
+    ssize_t result = write(socket_descriptor, data, length);
+#endif
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountSend(result, length);
+    }
+
+    return result;
+}
+
+// Size of user space buffer used where kernel zero-copy transfer is not available.
+#define TEOSOCK_TRANSFER_BUFFER_SIZE 65536
+
+// Sends a range of a file on a connected socket.
+ssize_t teosockSendFile(teonetSocket socket_descriptor, int file_descriptor, int64_t* offset, size_t length) {
+#if defined(TEONET_OS_LINUX)
+    off_t file_offset = (off_t)*offset;
+
+    ssize_t sent = sendfile(socket_descriptor, file_descriptor, &file_offset, length);
+
+    if (sent > 0) {
+        *offset = (int64_t)file_offset;
+    }
+
+    return sent;
+#else
+    uint8_t buffer[TEOSOCK_TRANSFER_BUFFER_SIZE];
+
+    if (length > sizeof(buffer)) {
+        length = sizeof(buffer);
+    }
+
+#if defined(TEONET_OS_WINDOWS)
+    if (_lseeki64(file_descriptor, *offset, SEEK_SET) == -1) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    ssize_t read_length = _read(file_descriptor, buffer, (unsigned int)length);
+#else
+    ssize_t read_length = pread(file_descriptor, buffer, length, (off_t)*offset);
+#endif
+
+    if (read_length <= 0) {
+        return read_length;
+    }
+
+    ssize_t sent = teosockSend(socket_descriptor, buffer, (size_t)read_length);
+
+    if (sent > 0) {
+        *offset += sent;
+    }
+
+    return sent;
+#endif
+}
+
+struct teosockRelay {
+#if defined(TEONET_OS_LINUX)
+    int pipe_descriptors[2];
+    size_t pipe_capacity;
+#else
+    uint8_t buffer[TEOSOCK_TRANSFER_BUFFER_SIZE];
+    size_t buffer_start;
+#endif
+    size_t pending_length;
+    bool source_closed;
+};
+
+// Creates a relay for forwarding data between sockets.
+teosockRelay* teosockRelayCreate(void) {
+    teosockRelay* relay = calloc(1, sizeof(teosockRelay));
+    if (relay == NULL) {
+        return NULL;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    if (pipe2(relay->pipe_descriptors, O_NONBLOCK | O_CLOEXEC) != 0) {
+        free(relay);
+        return NULL;
+    }
+
+    // Larger pipe moves more data per splice() call, failure to resize is not an error.
+    fcntl(relay->pipe_descriptors[1], F_SETPIPE_SZ, TEOSOCK_RELAY_PIPE_SIZE);
+
+    int pipe_capacity = fcntl(relay->pipe_descriptors[1], F_GETPIPE_SZ);
+    relay->pipe_capacity = pipe_capacity > 0 ? (size_t)pipe_capacity : TEOSOCK_TRANSFER_BUFFER_SIZE;
+#endif
+
+    return relay;
+}
+
+// Destroys a relay.
+void teosockRelayDestroy(teosockRelay* relay) {
+    if (relay == NULL) {
+        return;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    close(relay->pipe_descriptors[0]);
+    close(relay->pipe_descriptors[1]);
+#endif
+
+    free(relay);
+}
+
+// Move pending data to destination socket. Returns moved amount or TEOSOCK_SOCKET_ERROR.
+static ssize_t teosockRelayWrite(teosockRelay* relay, teonetSocket destination) {
+#if defined(TEONET_OS_LINUX)
+    return splice(relay->pipe_descriptors[0], NULL, destination, NULL, relay->pending_length,
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+#else
+    ssize_t sent = teosockSend(destination, relay->buffer + relay->buffer_start, relay->pending_length);
+
+    if (sent > 0) {
+        relay->buffer_start += (size_t)sent;
+    }
+
+    return sent;
+#endif
+}
+
+// Read source data into relay. Returns read amount, zero on end of stream or TEOSOCK_SOCKET_ERROR.
+static ssize_t teosockRelayRead(teosockRelay* relay, teonetSocket source) {
+#if defined(TEONET_OS_LINUX)
+    return splice(source, NULL, relay->pipe_descriptors[1], NULL, relay->pipe_capacity,
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+#else
+    relay->buffer_start = 0;
+
+    return teosockRecv(source, relay->buffer, sizeof(relay->buffer));
+#endif
+}
+
+// Forwards data from one socket to another.
+teosockRelayResult teosockRelayForward(
+    teosockRelay* relay, teonetSocket source, teonetSocket destination, size_t* relayed_length) {
+    size_t total_length = 0;
+
+    for (;;) {
+        if (relay->pending_length != 0) {
+            ssize_t written = teosockRelayWrite(relay, destination);
+
+            if (written < 0) {
+                if (!teosockRecvfromErrorIsRecoverable(teosockGetLastError())) {
+                    return TEOSOCK_RELAY_ERROR;
+                }
+
+                // Destination is full.
+                break;
+            }
+
+            relay->pending_length -= (size_t)written;
+            total_length += (size_t)written;
+
+            if (relay->pending_length != 0) {
+                continue;
+            }
+        }
+
+        if (relay->source_closed) {
+            break;
+        }
+
+        ssize_t read_length = teosockRelayRead(relay, source);
+
+        if (read_length < 0) {
+            if (!teosockRecvfromErrorIsRecoverable(teosockGetLastError())) {
+                return TEOSOCK_RELAY_ERROR;
+            }
+
+            // Source has no data.
+            break;
+        }
+
+        if (read_length == 0) {
+            relay->source_closed = true;
+            break;
+        }
+
+        relay->pending_length = (size_t)read_length;
+    }
+
+    if (relayed_length != NULL) {
+        *relayed_length = total_length;
+    }
+
+    if (relay->source_closed && relay->pending_length == 0) {
+        return TEOSOCK_RELAY_CLOSED;
+    }
+
+    return total_length != 0 ? TEOSOCK_RELAY_SUCCESS : TEOSOCK_RELAY_TRY_AGAIN;
+}
+
+// Gets amount of data read from source but not written to destination yet.
+size_t teosockRelayGetPendingLength(const teosockRelay* relay) {
+    return relay->pending_length;
+}
+
+// Enables zero-copy sends on a connected TCP socket.
+bool teosockZerocopyInit(teosockZerocopy* zerocopy, teonetSocket socket_descriptor, size_t min_length) {
+    memset(zerocopy, 0, sizeof(*zerocopy));
+    zerocopy->socket_descriptor = socket_descriptor;
+    zerocopy->min_length = min_length;
+
+#if defined(TEONET_OS_LINUX)
+    int flag = 1;
+
+    if (setsockopt(socket_descriptor, SOL_SOCKET, SO_ZEROCOPY, &flag, sizeof(flag)) == 0) {
+        zerocopy->enabled = true;
+    }
+#endif
+
+    return zerocopy->enabled;
+}
+
+// Sends data on a connected socket without copying it into the kernel if possible.
+ssize_t teosockSendZerocopy(teosockZerocopy* zerocopy, const uint8_t* data, size_t length,
+                            bool* in_flight, uint32_t* send_id) {
+    *in_flight = false;
+
+#if defined(TEONET_OS_LINUX)
+    if (zerocopy->enabled && length >= zerocopy->min_length) {
+        ssize_t sent_length = send(zerocopy->socket_descriptor, data, length, MSG_ZEROCOPY);
+
+        // Send retried with copying below is counted by teosockSend().
+        if (teosockStatsEnabled && (sent_length >= 0 || errno != ENOBUFS)) {
+            teosockStatsCountSend(sent_length, length);
+        }
+
+        if (sent_length >= 0) {
+            // The kernel numbers every successful zero-copy send in sequence.
+            *in_flight = true;
+            *send_id = zerocopy->next_id;
+            ++zerocopy->next_id;
+
+            return sent_length;
+        }
+
+        // Out of pinned memory limit, copy data instead.
+        if (errno != ENOBUFS) {
+            return TEOSOCK_SOCKET_ERROR;
+        }
+    }
+#endif
+
+    return teosockSend(zerocopy->socket_descriptor, data, length);
+}
+
+// Reads zero-copy completion notifications from socket error queue.
+int teosockZerocopyDrain(teosockZerocopy* zerocopy, teosockZerocopyCompletion* completions, size_t max_completions) {
+    int count = 0;
+
+#if defined(TEONET_OS_LINUX)
+    if (!zerocopy->enabled) {
+        return 0;
+    }
+
+    while ((size_t)count < max_completions) {
+        union {
+            char buffer[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+            struct cmsghdr align;
+        } control;
+
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        if (recvmsg(zerocopy->socket_descriptor, &header, MSG_ERRQUEUE) == -1) {
+            if (teosockRecvfromErrorIsRecoverable(errno)) {
+                break;
+            }
+
+            return count != 0 ? count : TEOSOCK_SOCKET_ERROR;
+        }
+
+        for (struct cmsghdr* control_message = CMSG_FIRSTHDR(&header); control_message != NULL;
+             control_message = CMSG_NXTHDR(&header, control_message)) {
+            bool is_ip_error = (control_message->cmsg_level == SOL_IP && control_message->cmsg_type == IP_RECVERR) ||
+                               (control_message->cmsg_level == SOL_IPV6 && control_message->cmsg_type == IPV6_RECVERR);
+            if (!is_ip_error) {
+                continue;
+            }
+
+            struct sock_extended_err error;
+            memcpy(&error, CMSG_DATA(control_message), sizeof(error));
+
+            if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            completions[count].first_id = error.ee_info;
+            completions[count].last_id = error.ee_data;
+            completions[count].copied = (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+            ++count;
+        }
+    }
+#endif
+
+    return count;
+}
+
+#if !defined(TEONET_OS_WINDOWS)
+// Maximum amount of buffers accepted by readv() and writev().
+#if defined(IOV_MAX)
+#define TEOSOCK_IOV_MAX IOV_MAX
+#else
+#define TEOSOCK_IOV_MAX 16
+#endif
+#endif
+
+// Sends data gathered from several buffers on a connected socket.
+ssize_t teosockSendv(teonetSocket socket_descriptor, const teosockIovec* iov, size_t iov_count) {
+    return teosockSendvFlags(socket_descriptor, iov, iov_count, 0);
+}
+
+// Sends data gathered from several buffers on a connected socket with send flags.
+ssize_t teosockSendvFlags(teonetSocket socket_descriptor, const teosockIovec* iov, size_t iov_count, int flags) {
+#if defined(TEONET_OS_WINDOWS)
+    if (iov_count > (size_t)MAXDWORD) {
+        iov_count = (size_t)MAXDWORD;
+    }
+
+    DWORD bytes_sent = 0;
+    int send_result = WSASend(socket_descriptor, (LPWSABUF)iov, (DWORD)iov_count, &bytes_sent, 0, NULL, NULL);
+
+    ssize_t result = send_result == 0 ? (ssize_t)bytes_sent : TEOSOCK_SOCKET_ERROR;
+#else
+    // Sending only first buffers is fine, caller has to handle partial send anyway.
+    if (iov_count > TEOSOCK_IOV_MAX) {
+        iov_count = TEOSOCK_IOV_MAX;
+    }
+
+    ssize_t result;
+
+#if defined(MSG_MORE)
+    if (flags & TEOSOCK_SEND_MORE) {
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_iov = (struct iovec*)iov;
+        header.msg_iovlen = iov_count;
+
+        result = sendmsg(socket_descriptor, &header, MSG_MORE);
+    } else
+#endif
+    {
+        // teosockIovec has the same layout as struct iovec.
+        result = writev(socket_descriptor, (const struct iovec*)iov, (int)iov_count);
+    }
+#endif
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountSend(result, teosockIovecLength(iov, iov_count));
+    }
+
+    return result;
+}
+
+// Receives data from a connected socket scattering it into several buffers.
+ssize_t teosockRecvv(teonetSocket socket_descriptor, teosockIovec* iov, size_t iov_count) {
+#if defined(TEONET_OS_WINDOWS)
+    if (iov_count > (size_t)MAXDWORD) {
+        iov_count = (size_t)MAXDWORD;
+    }
+
+    DWORD bytes_received = 0;
+    DWORD flags = 0;
+    int recv_result = WSARecv(socket_descriptor, (LPWSABUF)iov, (DWORD)iov_count, &bytes_received, &flags, NULL, NULL);
+
+    ssize_t result = recv_result == 0 ? (ssize_t)bytes_received : TEOSOCK_SOCKET_ERROR;
+#else
+    if (iov_count > TEOSOCK_IOV_MAX) {
+        iov_count = TEOSOCK_IOV_MAX;
+    }
+
+    // teosockIovec has the same layout as struct iovec.
+    ssize_t result = readv(socket_descriptor, (const struct iovec*)iov, (int)iov_count);
+#endif
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountRecv(result);
+    }
+
+    return result;
+}
+
+// Skips transferred bytes in an array of buffers after partial send or receive.
+size_t teosockIovecAdvance(teosockIovec** iov, size_t* iov_count, size_t length) {
+    teosockIovec* current = *iov;
+    size_t count = *iov_count;
+
+    while (count != 0 && length >= current->length) {
+        length -= current->length;
+        ++current;
+        --count;
+    }
+
+    if (count != 0 && length != 0) {
+        current->data += length;
+#if defined(TEONET_OS_WINDOWS)
+        current->length -= (ULONG)length;
+#else
+        current->length -= length;
+#endif
+    }
+
+    *iov = current;
+    *iov_count = count;
+
+    return count;
+}
+
+// Store failure of message in teosockSendtoBatch(). Returns true if sending should stop.
+static bool teosockSendtoBatchSetError(teosockSendtoMessage* message, int error_code) {
+    message->error_code = error_code;
+    message->sent_length = 0;
+
+    if (teosockRecvfromErrorIsRecoverable(error_code)) {
+        message->status = TEOSOCK_SENDTO_TRY_AGAIN;
+        return true;
+    }
+
+    message->status = TEOSOCK_SENDTO_FAILED;
+
+    return teosockSendErrorIsFatal(error_code);
+}
+
+#if defined(TEONET_OS_LINUX)
+// Maximum amount of datagrams sent by one sendmmsg() call.
+#define TEOSOCK_SENDTO_BATCH_SIZE 64
+#endif
+
+// Sends several datagrams, possibly to different destinations, in one call.
+size_t teosockSendtoBatch(teonetSocket socket_descriptor, teosockSendtoMessage* messages, size_t messages_count) {
+    size_t sent_count = 0;
+    size_t index = 0;
+
+#if defined(TEONET_OS_LINUX)
+    struct mmsghdr headers[TEOSOCK_SENDTO_BATCH_SIZE];
+
+    while (index < messages_count) {
+        size_t batch_count = messages_count - index;
+        if (batch_count > TEOSOCK_SENDTO_BATCH_SIZE) {
+            batch_count = TEOSOCK_SENDTO_BATCH_SIZE;
+        }
+
+        teosockSendtoMessage* batch = messages + index;
+        memset(headers, 0, sizeof(headers[0]) * batch_count);
+
+        for (size_t i = 0; i < batch_count; ++i) {
+            headers[i].msg_hdr.msg_name = (void*)batch[i].address;
+            headers[i].msg_hdr.msg_namelen = batch[i].address != NULL ? batch[i].address_length : 0;
+            // teosockIovec has the same layout as struct iovec.
+            headers[i].msg_hdr.msg_iov = (struct iovec*)batch[i].iov;
+            headers[i].msg_hdr.msg_iovlen = batch[i].iov_count;
+        }
+
+        int send_count;
+        do {
+            send_count = sendmmsg(socket_descriptor, headers, (unsigned int)batch_count, 0);
+        } while (send_count == -1 && errno == EINTR);
+
+        if (teosockStatsEnabled) {
+            if (send_count == -1) {
+                teosockStatsCountSend(-1, 0);
+            }
+
+            for (int i = 0; i < send_count; ++i) {
+                teosockStatsCountSend(
+                    (ssize_t)headers[i].msg_len, teosockIovecLength(batch[i].iov, batch[i].iov_count));
+            }
+        }
+
+        if (send_count > 0) {
+            for (int i = 0; i < send_count; ++i) {
+                batch[i].status = TEOSOCK_SENDTO_SENT;
+                batch[i].sent_length = headers[i].msg_len;
+                batch[i].error_code = 0;
+            }
+
+            index += (size_t)send_count;
+            sent_count += (size_t)send_count;
+            continue;
+        }
+
+        // sendmmsg() reports error only if the first message in batch failed.
+        bool stop = teosockSendtoBatchSetError(&batch[0], teosockGetLastError());
+        ++index;
+
+        if (stop) {
+            break;
+        }
+    }
+#else
+    while (index < messages_count) {
+        teosockSendtoMessage* message = &messages[index];
+        ++index;
+
+#if defined(TEONET_OS_WINDOWS)
+        DWORD bytes_sent = 0;
+        int send_result = WSASendTo(socket_descriptor, (LPWSABUF)message->iov, (DWORD)message->iov_count,
+                                    &bytes_sent, 0, message->address,
+                                    message->address != NULL ? message->address_length : 0, NULL, NULL);
+        ssize_t send_length = (send_result == 0) ? (ssize_t)bytes_sent : -1;
+#else
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_name = (void*)message->address;
+        header.msg_namelen = message->address != NULL ? message->address_length : 0;
+        // teosockIovec has the same layout as struct iovec.
+        header.msg_iov = (struct iovec*)message->iov;
+        header.msg_iovlen = (int)message->iov_count;
+
+        ssize_t send_length;
+        do {
+            send_length = sendmsg(socket_descriptor, &header, 0);
+        } while (send_length == -1 && errno == EINTR);
+#endif
+
+        if (teosockStatsEnabled) {
+            teosockStatsCountSend(send_length, teosockIovecLength(message->iov, message->iov_count));
+        }
+
+        if (send_length >= 0) {
+            message->status = TEOSOCK_SENDTO_SENT;
+            message->sent_length = (size_t)send_length;
+            message->error_code = 0;
+            ++sent_count;
+        } else if (teosockSendtoBatchSetError(message, teosockGetLastError())) {
+            break;
+        }
+    }
+#endif
+
+    for (; index < messages_count; ++index) {
+        messages[index].status = TEOSOCK_SENDTO_NOT_SENT;
+        messages[index].sent_length = 0;
+        messages[index].error_code = 0;
+    }
+
+    return sent_count;
+}
+
+// Set error code returned by teosockGetLastError().
+static void teosockSetLastError(int error_code) {
+#if defined(TEONET_OS_WINDOWS)
+    WSASetLastError(error_code);
+#else
+    errno = error_code;
+#endif
+}
+
+// Enable UDP segmentation offload modes on a datagram socket.
+int teosockSetUdpOffload(teonetSocket socket_descriptor, int offload_mask) {
+    int enabled_mask = 0;
+
+#if defined(TEONET_OS_LINUX)
+    if (offload_mask & TEOSOCK_UDP_OFFLOAD_SEGMENT) {
+        // Segment size is passed with every send, zero socket default only checks kernel support.
+        int segment_size = 0;
+
+        if (setsockopt(socket_descriptor, SOL_UDP, UDP_SEGMENT, &segment_size, sizeof(segment_size)) == 0) {
+            enabled_mask |= TEOSOCK_UDP_OFFLOAD_SEGMENT;
+        }
+    }
+
+    if (offload_mask & TEOSOCK_UDP_OFFLOAD_GRO) {
+        int flag = 1;
+
+        if (setsockopt(socket_descriptor, SOL_UDP, UDP_GRO, &flag, sizeof(flag)) == 0) {
+            enabled_mask |= TEOSOCK_UDP_OFFLOAD_GRO;
+        }
+    }
+#endif
+
+    return enabled_mask;
+}
+
+// Maximum payload of one UDP datagram over IPv4.
+#define TEOSOCK_UDP_MAX_PAYLOAD 65507
+
+#if defined(TEONET_OS_LINUX)
+// Check if error code of UDP_SEGMENT send means that kernel or device does not support it.
+static bool teosockUdpSegmentErrorIsUnsupported(int error_code) {
+    return error_code == EIO || error_code == EINVAL || error_code == ENOPROTOOPT || error_code == EOPNOTSUPP;
+}
+#endif
+
+// Sends buffer as a train of datagrams using teosockSendtoBatch().
+static ssize_t teosockSendtoSegmentedFallback(
+    teonetSocket socket_descriptor, const uint8_t* data, size_t length, size_t segment_size,
+    const struct sockaddr* address, socklen_t address_length) {
+    teosockSendtoMessage messages[TEOSOCK_UDP_MAX_SEGMENTS];
+    teosockIovec vectors[TEOSOCK_UDP_MAX_SEGMENTS];
+    size_t offset = 0;
+
+    while (offset < length) {
+        size_t count = 0;
+        size_t batch_offset = offset;
+
+        while (count < TEOSOCK_UDP_MAX_SEGMENTS && batch_offset < length) {
+            size_t datagram_length = length - batch_offset;
+            if (datagram_length > segment_size) {
+                datagram_length = segment_size;
+            }
+
+            vectors[count].data = (uint8_t*)data + batch_offset;
+#if defined(TEONET_OS_WINDOWS)
+            vectors[count].length = (ULONG)datagram_length;
+#else
+            vectors[count].length = datagram_length;
+#endif
+
+            memset(&messages[count], 0, sizeof(messages[count]));
+            messages[count].address = address;
+            messages[count].address_length = address_length;
+            messages[count].iov = &vectors[count];
+            messages[count].iov_count = 1;
+
+            batch_offset += datagram_length;
+            ++count;
+        }
+
+        teosockSendtoBatch(socket_descriptor, messages, count);
+
+        for (size_t i = 0; i < count; ++i) {
+            if (messages[i].status != TEOSOCK_SENDTO_SENT) {
+                if (offset != 0) {
+                    return (ssize_t)offset;
+                }
+
+                teosockSetLastError(messages[i].error_code);
+                return TEOSOCK_SOCKET_ERROR;
+            }
+
+            offset += vectors[i].length;
+        }
+    }
+
+    return (ssize_t)offset;
+}
+
+// Sends a buffer as a train of datagrams of equal size.
+ssize_t teosockSendtoSegmented(
+    teonetSocket socket_descriptor, const uint8_t* data, size_t length, size_t segment_size,
+    const struct sockaddr* address, socklen_t address_length) {
+    if (segment_size == 0) {
+#if defined(TEONET_OS_WINDOWS)
+        teosockSetLastError(WSAEINVAL);
+#else
+        teosockSetLastError(EINVAL);
+#endif
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    if (segment_size >= length || segment_size > TEOSOCK_UDP_MAX_PAYLOAD) {
+        return teosockSendtoSegmentedFallback(socket_descriptor, data, length, segment_size, address, address_length);
+    }
+
+    // Super-buffer must fit into one UDP datagram and must not exceed kernel segments limit.
+    size_t segments_per_send = TEOSOCK_UDP_MAX_PAYLOAD / segment_size;
+    if (segments_per_send > TEOSOCK_UDP_MAX_SEGMENTS) {
+        segments_per_send = TEOSOCK_UDP_MAX_SEGMENTS;
+    }
+
+    size_t max_send_length = segments_per_send * segment_size;
+    size_t offset = 0;
+
+    while (offset < length) {
+        size_t send_length = length - offset;
+        if (send_length > max_send_length) {
+            send_length = max_send_length;
+        }
+
+        struct iovec vector;
+        vector.iov_base = (uint8_t*)data + offset;
+        vector.iov_len = send_length;
+
+        union {
+            char buffer[CMSG_SPACE(sizeof(uint16_t))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_name = (void*)address;
+        header.msg_namelen = address != NULL ? address_length : 0;
+        header.msg_iov = &vector;
+        header.msg_iovlen = 1;
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        struct cmsghdr* control_message = CMSG_FIRSTHDR(&header);
+        control_message->cmsg_level = SOL_UDP;
+        control_message->cmsg_type = UDP_SEGMENT;
+        control_message->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t gso_size = (uint16_t)segment_size;
+        memcpy(CMSG_DATA(control_message), &gso_size, sizeof(gso_size));
+
+        ssize_t sent_length = sendmsg(socket_descriptor, &header, 0);
+
+        // Send retried without offload below is counted by teosockSendtoBatch().
+        if (teosockStatsEnabled && (sent_length != -1 || !teosockUdpSegmentErrorIsUnsupported(errno))) {
+            teosockStatsCountSendSegments(sent_length, send_length, segment_size);
+        }
+
+        if (sent_length == -1) {
+            // Kernel or device without UDP_SEGMENT support, send datagrams one by one.
+            if (teosockUdpSegmentErrorIsUnsupported(errno)) {
+                ssize_t fallback_length = teosockSendtoSegmentedFallback(
+                    socket_descriptor, data + offset, length - offset, segment_size, address, address_length);
+
+                if (fallback_length == TEOSOCK_SOCKET_ERROR) {
+                    return offset != 0 ? (ssize_t)offset : TEOSOCK_SOCKET_ERROR;
+                }
+
+                return (ssize_t)(offset + (size_t)fallback_length);
+            }
+
+            return offset != 0 ? (ssize_t)offset : TEOSOCK_SOCKET_ERROR;
+        }
+
+        offset += (size_t)sent_length;
+    }
+
+    return (ssize_t)offset;
+#else
+    return teosockSendtoSegmentedFallback(socket_descriptor, data, length, segment_size, address, address_length);
+#endif
+}
+
+// Receives data from a datagram socket that may contain several coalesced datagrams.
+teosockRecvfromResult teosockRecvfromSegmented(
+    teonetSocket socket_descriptor, uint8_t* buffer, size_t buffer_size,
+    struct sockaddr* __restrict address, socklen_t* address_length,
+    size_t* received_length, size_t* segment_size, int* error_code) {
+#if defined(TEONET_OS_LINUX)
+    struct iovec vector;
+    vector.iov_base = buffer;
+    vector.iov_len = buffer_size;
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = address;
+    header.msg_namelen = address_length != NULL ? *address_length : 0;
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+    ssize_t recvlen = recvmsg(socket_descriptor, &header, 0);
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountRecv(recvlen);
+    }
+
+    if (recvlen == -1) {
+        int recv_errno = teosockGetLastError();
+
+        if (error_code != NULL) {
+            *error_code = recv_errno;
+        }
+
+        return teosockRecvfromErrorToResult(recv_errno);
+    } else if (recvlen == 0) {
+        return TEOSOCK_RECVFROM_ORDERLY_CLOSED;
+    }
+
+    if (address_length != NULL) {
+        *address_length = header.msg_namelen;
+    }
 
-    memset(&serveraddr, 0, sizeof(struct sockaddr_in));
-    serveraddr.sin_family = AF_INET;
-    serveraddr.sin_port = htons(port);
+    size_t gso_size = (size_t)recvlen;
 
-#if !defined(TEONET_COMPILER_MINGW)
-    int result = inet_pton(AF_INET, server, &serveraddr.sin_addr);
+    for (struct cmsghdr* control_message = CMSG_FIRSTHDR(&header); control_message != NULL;
+         control_message = CMSG_NXTHDR(&header, control_message)) {
+        if (control_message->cmsg_level == SOL_UDP && control_message->cmsg_type == UDP_GRO) {
+            int value = 0;
+            memcpy(&value, CMSG_DATA(control_message), sizeof(value));
 
-    // Resolve host address if needed.
-    if (result != 1) {
-        struct hostent* hostp = gethostbyname(server);
-        if (hostp == NULL) {
-            return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+            if (value > 0) {
+                gso_size = (size_t)value;
+            }
         }
+    }
+
+    if (received_length != NULL) {
+        *received_length = (size_t)recvlen;
+    }
 
-        memcpy(&serveraddr.sin_addr, hostp->h_addr_list[0], sizeof(serveraddr.sin_addr));
+    if (segment_size != NULL) {
+        *segment_size = gso_size;
     }
+
+    return TEOSOCK_RECVFROM_DATA_RECEIVED;
 #else
-    // MinGW compiler still doest not support inet_pton().
-    serveraddr.sin_addr.s_addr = inet_addr(server);
+    size_t length = 0;
 
-    // Resolve host address if needed.
-    if (serveraddr.sin_addr.s_addr == (unsigned long)INADDR_NONE) {
-        struct hostent* hostp = gethostbyname(server);
-        if (hostp == NULL) {
-            return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+    teosockRecvfromResult recvfrom_result = teosockRecvfrom(
+        socket_descriptor, buffer, buffer_size, address, address_length, &length, error_code);
+
+    if (recvfrom_result == TEOSOCK_RECVFROM_DATA_RECEIVED) {
+        if (received_length != NULL) {
+            *received_length = length;
         }
 
-        memcpy(&serveraddr.sin_addr, hostp->h_addr_list[0], sizeof(serveraddr.sin_addr));
+        if (segment_size != NULL) {
+            *segment_size = length;
+        }
     }
+
+    return recvfrom_result;
 #endif
+}
 
-    // Connect to server.
-    int connect_result = connect(socket_descriptor, (struct sockaddr*)&serveraddr, sizeof(serveraddr));
-    if (connect_result != 0 && errno != EINPROGRESS) {
-        return TEOSOCK_CONNECT_FAILED;
+// Splits buffer received by teosockRecvfromSegmented() into per-datagram views.
+size_t teosockSplitSegments(
+    uint8_t* buffer, size_t received_length, size_t segment_size,
+    teosockIovec* views, size_t views_count) {
+    if (segment_size == 0) {
+        segment_size = received_length;
     }
 
-    return TEOSOCK_CONNECT_SUCCESS;
-}
+    size_t count = 0;
+    size_t offset = 0;
 
-// Establishes a connection to a specified server.
-// TODO: Cleanup and double check this function implementation.
-teosockConnectResult teosockConnectTimeout(teonetSocket* socket_descriptor, const char* server, uint16_t port, int timeout_ms) {
-    struct addrinfo hints;
-    struct addrinfo* rp;
-    struct addrinfo* res;
-    memset(&hints, '\0', sizeof(struct addrinfo));
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_protocol = IPPROTO_TCP;
-    int fd, n;
-    int connect_result = -1;
-
-    char port_ch[10];
-    snprintf(port_ch, sizeof(port_ch), "%d", port);
-    if ((n = getaddrinfo(server, port_ch, &hints, &res)) != 0) {
-        LTRACK_E("TeonetClient", "getaddrinfo: %s", gai_strerror(n));
-        return TEOSOCK_CONNECT_HOST_NOT_FOUND;
+    while (offset < received_length && count < views_count) {
+        size_t datagram_length = received_length - offset;
+        if (datagram_length > segment_size) {
+            datagram_length = segment_size;
+        }
+
+        views[count].data = buffer + offset;
+#if defined(TEONET_OS_WINDOWS)
+        views[count].length = (ULONG)datagram_length;
+#else
+        views[count].length = datagram_length;
+#endif
+
+        offset += datagram_length;
+        ++count;
     }
 
-    for (rp = res; rp != NULL; rp = rp->ai_next) {
-        fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-        if (fd == -1) continue;
+    return count;
+}
 
-        int set_non_locking_result = teosockSetBlockingMode(fd, TEOSOCK_NON_BLOCKING_MODE);
+// Enables kernel timestamping of received and sent packets.
+int teosockSetTimestamping(teonetSocket socket_descriptor, int timestamping_flags) {
+#if defined(TEONET_OS_LINUX)
+    int flags = 0;
 
-        if (set_non_locking_result == TEOSOCK_SOCKET_ERROR) {
-            teosockClose(fd);
-            continue;
-        }
+    if (timestamping_flags & (TEOSOCK_TIMESTAMPING_RX_SOFTWARE | TEOSOCK_TIMESTAMPING_TX_SOFTWARE)) {
+        flags |= SOF_TIMESTAMPING_SOFTWARE;
+    }
 
-        connect_result = connect(fd, rp->ai_addr, rp->ai_addrlen);
-        if (connect_result == 0) {
-            goto success_connect;
-        } else {
-            int in_progress = 0;
+    if (timestamping_flags & (TEOSOCK_TIMESTAMPING_RX_HARDWARE | TEOSOCK_TIMESTAMPING_TX_HARDWARE)) {
+        flags |= SOF_TIMESTAMPING_RAW_HARDWARE;
+    }
 
-            #if defined(TEONET_OS_WINDOWS)
-            int error_code = WSAGetLastError();
+    if (timestamping_flags & TEOSOCK_TIMESTAMPING_RX_SOFTWARE) {
+        flags |= SOF_TIMESTAMPING_RX_SOFTWARE;
+    }
 
-            if (error_code == WSAEWOULDBLOCK) {
-                in_progress = 1;
-            }
-            #else
-            int error_code = errno;
+    if (timestamping_flags & TEOSOCK_TIMESTAMPING_RX_HARDWARE) {
+        flags |= SOF_TIMESTAMPING_RX_HARDWARE;
+    }
 
-            if (error_code == EINPROGRESS) {
-                in_progress = 1;
-            }
-            #endif
+    if (timestamping_flags & TEOSOCK_TIMESTAMPING_TX_SOFTWARE) {
+        flags |= SOF_TIMESTAMPING_TX_SOFTWARE;
+    }
 
-            if (in_progress != 1) {
-                teosockClose(fd);
-                continue;
-            }
-        }
+    if (timestamping_flags & TEOSOCK_TIMESTAMPING_TX_HARDWARE) {
+        flags |= SOF_TIMESTAMPING_TX_HARDWARE;
+    }
 
-        int select_result = teosockSelect(fd, TEOSOCK_SELECT_MODE_WRITE | TEOSOCK_SELECT_MODE_ERROR, timeout_ms);
+    if (timestamping_flags & (TEOSOCK_TIMESTAMPING_TX_SOFTWARE | TEOSOCK_TIMESTAMPING_TX_HARDWARE)) {
+        // Number sends to match timestamps with them, do not loop payload back into error queue.
+        flags |= SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    }
 
-        if (select_result == TEOSOCK_SELECT_TIMEOUT || select_result == TEOSOCK_SELECT_ERROR) {
-            teosockClose(fd);
-            continue;
+    if (setsockopt(socket_descriptor, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0) {
+        return TEOSOCK_SOCKET_SUCCESS;
+    }
+
+    // Older kernels still provide software receive timestamps.
+    if (timestamping_flags == TEOSOCK_TIMESTAMPING_RX_SOFTWARE) {
+        int enable = 1;
+        if (setsockopt(socket_descriptor, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0) {
+            return TEOSOCK_SOCKET_SUCCESS;
         }
+    }
+#endif
 
-        int error = 0;
-        socklen_t error_len = sizeof(error);
+    return TEOSOCK_SOCKET_ERROR;
+}
 
-        int getsockopt_result = getsockopt(fd, SOL_SOCKET, SO_ERROR, (char*)&error, &error_len);
+#if defined(TEONET_OS_LINUX)
+// Size of control buffer enough for timestamps and extended error.
+#define TEOSOCK_TIMESTAMP_CONTROL_SIZE \
+    (CMSG_SPACE(sizeof(struct scm_timestamping)) + \
+     CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6)))
 
-        if (getsockopt_result == TEOSOCK_SOCKET_ERROR || error != 0) {
-            teosockClose(fd);
-            continue;
-        } else {
-            goto success_connect;
-        }
+// Convert timespec to nanoseconds.
+static int64_t teosockTimespecToNs(const struct timespec* time_value) {
+    return (int64_t)time_value->tv_sec * NANOSECONDS_IN_SECOND + time_value->tv_nsec;
+}
 
-        teosockClose(fd);
+// Fill timestamp from timestamping control message. Returns false if message does not contain timestamps.
+static bool teosockParseTimestamp(const struct cmsghdr* control_message, teosockTimestamp* timestamp) {
+    if (control_message->cmsg_level != SOL_SOCKET) {
+        return false;
     }
 
-    freeaddrinfo(res);
-    return TEOSOCK_CONNECT_FAILED;
-
-success_connect:
-    freeaddrinfo(res);
-    *socket_descriptor = fd;
-    return TEOSOCK_CONNECT_SUCCESS;
+    if (control_message->cmsg_type == SCM_TIMESTAMPING) {
+        struct scm_timestamping timestamps;
+        memcpy(&timestamps, CMSG_DATA(control_message), sizeof(timestamps));
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Legacy implementation.
+        timestamp->software_ns = teosockTimespecToNs(&timestamps.ts[0]);
+        timestamp->hardware_ns = teosockTimespecToNs(&timestamps.ts[2]);
+        return true;
+    }
 
-// #if !defined(TEONET_COMPILER_MINGW)
-//     int result = inet_pton(AF_INET, server, &serveraddr.sin_addr);
+    if (control_message->cmsg_type == SCM_TIMESTAMPNS) {
+        struct timespec time_value;
+        memcpy(&time_value, CMSG_DATA(control_message), sizeof(time_value));
 
-//     // Resolve host address if needed.
-//     if (result != 1) {
-//         struct hostent* hostp = gethostbyname(server);
-//         if (hostp == NULL) {
-//             return TEOSOCK_CONNECT_HOST_NOT_FOUND;
-//         }
+        timestamp->software_ns = teosockTimespecToNs(&time_value);
+        return true;
+    }
 
-//         memcpy(&serveraddr.sin_addr, hostp->h_addr_list[0], sizeof(serveraddr.sin_addr));
-//     }
-// #else
-//     // MinGW compiler still doest not support inet_pton().
-//     serveraddr.sin_addr.s_addr = inet_addr(server);
+    return false;
+}
+#endif
 
-//     // Resolve host address if needed.
-//     if (serveraddr.sin_addr.s_addr == (unsigned long)INADDR_NONE) {
-//         struct hostent* hostp = gethostbyname(server);
-//         if (hostp == NULL) {
-//             return TEOSOCK_CONNECT_HOST_NOT_FOUND;
-//         }
+// Receives a datagram with its kernel receive timestamp.
+teosockRecvfromResult teosockRecvfromTimestamped(
+    teonetSocket socket_descriptor, uint8_t* buffer, size_t buffer_size,
+    struct sockaddr* __restrict address, socklen_t* address_length,
+    size_t* received_length, teosockTimestamp* timestamp, int* error_code) {
+    timestamp->software_ns = 0;
+    timestamp->hardware_ns = 0;
+
+#if defined(TEONET_OS_LINUX)
+    struct iovec vector;
+    vector.iov_base = buffer;
+    vector.iov_len = buffer_size;
+
+    union {
+        char buffer[TEOSOCK_TIMESTAMP_CONTROL_SIZE];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = address;
+    header.msg_namelen = address_length != NULL ? *address_length : 0;
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+    ssize_t recvlen = recvmsg(socket_descriptor, &header, 0);
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountRecv(recvlen);
+    }
 
-//         memcpy(&serveraddr.sin_addr, hostp->h_addr_list[0], sizeof(serveraddr.sin_addr));
-//     }
-// #endif
+    if (recvlen == -1) {
+        int recv_errno = teosockGetLastError();
 
-//     int set_non_locking_result = teosockSetBlockingMode(socket, TEOSOCK_NON_BLOCKING_MODE);
+        if (error_code != NULL) {
+            *error_code = recv_errno;
+        }
 
-//     if (set_non_locking_result == TEOSOCK_SOCKET_ERROR) {
-//         teosockClose(socket);
-//         return TEOSOCK_CONNECT_FAILED;
-//     }
+        return teosockRecvfromErrorToResult(recv_errno);
+    } else if (recvlen == 0) {
+        return TEOSOCK_RECVFROM_ORDERLY_CLOSED;
+    }
 
-//     // Connect to server.
-//     int connect_result = connect(socket, (struct sockaddr*)&serveraddr, sizeof(serveraddr));
+    if (address_length != NULL) {
+        *address_length = header.msg_namelen;
+    }
 
-//     if (connect_result == 0) {
-//         return TEOSOCK_CONNECT_SUCCESS;
-//     }
-//     else {
-//         int in_progress = 0;
+    for (struct cmsghdr* control_message = CMSG_FIRSTHDR(&header); control_message != NULL;
+         control_message = CMSG_NXTHDR(&header, control_message)) {
+        teosockParseTimestamp(control_message, timestamp);
+    }
 
-// #if defined(TEONET_OS_WINDOWS)
-//         int error_code = WSAGetLastError();
+    if (received_length != NULL) {
+        *received_length = (size_t)recvlen;
+    }
 
-//         if (error_code == WSAEWOULDBLOCK) {
-//             in_progress = 1;
-//         }
-// #else
-//         int error_code = errno;
+    return TEOSOCK_RECVFROM_DATA_RECEIVED;
+#else
+    return teosockRecvfrom(
+        socket_descriptor, buffer, buffer_size, address, address_length, received_length, error_code);
+#endif
+}
 
-//         if (error_code == EINPROGRESS) {
-//             in_progress = 1;
-//         }
-// #endif
+// Reads transmit timestamps from socket error queue.
+int teosockTxTimestampDrain(teonetSocket socket_descriptor, teosockTxTimestamp* timestamps, size_t max_timestamps) {
+    int count = 0;
+
+#if defined(TEONET_OS_LINUX)
+    while ((size_t)count < max_timestamps) {
+        union {
+            char buffer[TEOSOCK_TIMESTAMP_CONTROL_SIZE];
+            struct cmsghdr align;
+        } control;
+
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        if (recvmsg(socket_descriptor, &header, MSG_ERRQUEUE) == -1) {
+            if (teosockRecvfromErrorIsRecoverable(errno)) {
+                break;
+            }
 
-//         if (in_progress != 1) {
-//             teosockClose(socket);
-//             return TEOSOCK_CONNECT_FAILED;
-//         }
-//     }
+            return count != 0 ? count : TEOSOCK_SOCKET_ERROR;
+        }
 
-//     int select_result = teosockSelect(socket, TEOSOCK_SELECT_MODE_WRITE | TEOSOCK_SELECT_MODE_ERROR, timeout_ms);
+        // Timestamps and send identifier come in separate control messages of one error queue message.
+        teosockTimestamp timestamp = {0, 0};
+        bool has_timestamp = false;
+        bool has_id = false;
+        uint32_t id = 0;
+        uint32_t type = 0;
+
+        for (struct cmsghdr* control_message = CMSG_FIRSTHDR(&header); control_message != NULL;
+             control_message = CMSG_NXTHDR(&header, control_message)) {
+            if (teosockParseTimestamp(control_message, &timestamp)) {
+                has_timestamp = true;
+                continue;
+            }
 
-//     if (select_result == TEOSOCK_SELECT_TIMEOUT || select_result == TEOSOCK_SELECT_ERROR) {
-//         teosockClose(socket);
-//         return TEOSOCK_CONNECT_FAILED;
-//     }
+            bool is_ip_error = (control_message->cmsg_level == SOL_IP && control_message->cmsg_type == IP_RECVERR) ||
+                               (control_message->cmsg_level == SOL_IPV6 && control_message->cmsg_type == IPV6_RECVERR);
+            if (!is_ip_error) {
+                continue;
+            }
 
-//     int error = 0;
-//     socklen_t error_len = sizeof(error);
+            struct sock_extended_err error;
+            memcpy(&error, CMSG_DATA(control_message), sizeof(error));
 
-//     int getsockopt_result = getsockopt(socket, SOL_SOCKET, SO_ERROR, (char*)&error, &error_len);
+            if (error.ee_errno == ENOMSG && error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                id = error.ee_data;
+                type = error.ee_info;
+                has_id = true;
+            }
+        }
 
-//     if (getsockopt_result == TEOSOCK_SOCKET_ERROR || error != 0) {
-//         teosockClose(socket);
-//         return TEOSOCK_CONNECT_FAILED;
-//     }
+        if (has_timestamp && has_id) {
+            timestamps[count].id = id;
+            timestamps[count].type = (teosockTxTimestampType)type;
+            timestamps[count].timestamp = timestamp;
+            ++count;
+        }
+    }
+#endif
 
-//     return TEOSOCK_CONNECT_SUCCESS;
+    return count;
 }
 
-// Receives data from a connected socket.
-ssize_t teosockRecv(teonetSocket socket_descriptor, uint8_t* data, size_t length) {
+// Enables reception of datagram destination address, interface, TTL and traffic class.
+int teosockSetDatagramInfo(teonetSocket socket_descriptor) {
 #if defined(TEONET_OS_WINDOWS)
-    if (length > (ssize_t)INT_MAX) {
-        // Can't receive this much data.
+    return TEOSOCK_SOCKET_ERROR;
+#else
+    struct sockaddr_storage address;
+    socklen_t address_length = sizeof(address);
+
+    if (getsockname(socket_descriptor, (struct sockaddr*)&address, &address_length) != 0) {
         return TEOSOCK_SOCKET_ERROR;
     }
 
-    return recv(socket_descriptor, (char*)data, (int)length, 0);
-#else
-    return read(socket_descriptor, data, length);
-#endif
-}
+    int enable = 1;
+    bool success = true;
 
-// Check if error code from recvfrom is recoverable socket error.
-static bool teosockRecvfromErrorIsRecoverable(int error_code) {
-#if defined(TEONET_OS_WINDOWS)
-    return error_code == WSAEWOULDBLOCK;
-#else
-    // EWOULDBLOCK may be not defined or may have same value as EAGAIN.
-#if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
-    return error_code == EAGAIN || error_code == EWOULDBLOCK;
-#else
-    return error_code == EAGAIN;
+    if (address.ss_family == AF_INET6) {
+        success &= setsockopt(socket_descriptor, IPPROTO_IPV6, IPV6_RECVPKTINFO, &enable, sizeof(enable)) == 0;
+        success &= setsockopt(socket_descriptor, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &enable, sizeof(enable)) == 0;
+        success &= setsockopt(socket_descriptor, IPPROTO_IPV6, IPV6_RECVTCLASS, &enable, sizeof(enable)) == 0;
+    }
+
+    // Dual-stack IPv6 sockets receive IPv4 datagrams with IPv4 control messages, failure is fine there.
+    bool ipv4_success = true;
+#if defined(IP_PKTINFO)
+    ipv4_success &= setsockopt(socket_descriptor, IPPROTO_IP, IP_PKTINFO, &enable, sizeof(enable)) == 0;
+#endif
+#if defined(IP_RECVTTL)
+    ipv4_success &= setsockopt(socket_descriptor, IPPROTO_IP, IP_RECVTTL, &enable, sizeof(enable)) == 0;
 #endif
+#if defined(IP_RECVTOS)
+    ipv4_success &= setsockopt(socket_descriptor, IPPROTO_IP, IP_RECVTOS, &enable, sizeof(enable)) == 0;
+#endif
+
+    if (address.ss_family == AF_INET) {
+        success &= ipv4_success;
+    }
+
+    return success ? TEOSOCK_SOCKET_SUCCESS : TEOSOCK_SOCKET_ERROR;
 #endif
 }
 
-// Check if error code from recvfrom is fatal socket error.
-static bool teosockRecvfromErrorIsFatal(int error_code) {
-#if defined(TEONET_OS_WINDOWS)
-    return error_code == WSAEFAULT || error_code == WSAEINVAL ||
-           error_code == WSAENOTSOCK || error_code == WSAESHUTDOWN;
-#else
-    return error_code == ENOTCONN || error_code == EBADF;
+#if !defined(TEONET_OS_WINDOWS)
+// Read TTL or traffic class stored as int or as single byte depending on platform.
+static int teosockReadControlByteOrInt(const struct cmsghdr* control_message) {
+    if (control_message->cmsg_len >= CMSG_LEN(sizeof(int))) {
+        int value;
+        memcpy(&value, CMSG_DATA(control_message), sizeof(value));
+        return value;
+    }
+
+    return *(const uint8_t*)CMSG_DATA(control_message);
+}
+
+// Fill datagram information from control message.
+static void teosockParseDatagramInfo(const struct cmsghdr* control_message, teosockDatagramInfo* info) {
+    if (control_message->cmsg_level == IPPROTO_IP) {
+#if defined(IP_PKTINFO)
+        if (control_message->cmsg_type == IP_PKTINFO) {
+            struct in_pktinfo packet_info;
+            memcpy(&packet_info, CMSG_DATA(control_message), sizeof(packet_info));
+
+            struct sockaddr_in* local_address = (struct sockaddr_in*)&info->local_address;
+            memset(local_address, 0, sizeof(*local_address));
+            local_address->sin_family = AF_INET;
+            local_address->sin_addr = packet_info.ipi_addr;
+
+            info->local_address_length = sizeof(*local_address);
+            info->interface_index = (unsigned int)packet_info.ipi_ifindex;
+        }
+#endif
+#if defined(IP_RECVTTL)
+        if (control_message->cmsg_type == IP_TTL || control_message->cmsg_type == IP_RECVTTL) {
+            info->ttl = teosockReadControlByteOrInt(control_message);
+        }
+#endif
+#if defined(IP_RECVTOS)
+        if (control_message->cmsg_type == IP_TOS || control_message->cmsg_type == IP_RECVTOS) {
+            info->ecn = teosockReadControlByteOrInt(control_message) & TEOSOCK_ECN_MASK;
+        }
 #endif
+    } else if (control_message->cmsg_level == IPPROTO_IPV6) {
+        if (control_message->cmsg_type == IPV6_PKTINFO) {
+            struct in6_pktinfo packet_info;
+            memcpy(&packet_info, CMSG_DATA(control_message), sizeof(packet_info));
+
+            struct sockaddr_in6* local_address = (struct sockaddr_in6*)&info->local_address;
+            memset(local_address, 0, sizeof(*local_address));
+            local_address->sin6_family = AF_INET6;
+            local_address->sin6_addr = packet_info.ipi6_addr;
+
+            info->local_address_length = sizeof(*local_address);
+            info->interface_index = (unsigned int)packet_info.ipi6_ifindex;
+        } else if (control_message->cmsg_type == IPV6_HOPLIMIT) {
+            info->ttl = teosockReadControlByteOrInt(control_message);
+        } else if (control_message->cmsg_type == IPV6_TCLASS) {
+            info->ecn = teosockReadControlByteOrInt(control_message) & TEOSOCK_ECN_MASK;
+        }
+    }
 }
+#endif
 
-// Receives data from a connection-mode or connectionless-mode socket.
-teosockRecvfromResult teosockRecvfrom(
+// Receives a datagram with its destination address, interface, TTL and ECN bits.
+teosockRecvfromResult teosockRecvfromDatagramInfo(
     teonetSocket socket_descriptor, uint8_t* buffer, size_t buffer_size,
     struct sockaddr* __restrict address, socklen_t* address_length,
-    size_t* received_length, int* error_code) {
-    teosockRecvfromResult udp_recvfrom_result = TEOSOCK_RECVFROM_UNKNOWN_ERROR;
-    int flags = 0;
+    size_t* received_length, teosockDatagramInfo* info, int* error_code) {
+    memset(info, 0, sizeof(*info));
+    info->ttl = -1;
+    info->ecn = -1;
 
 #if defined(TEONET_OS_WINDOWS)
-    if (buffer_size > (size_t)INT_MAX) {
-        buffer_size = (size_t)INT_MAX;
-    }
-    ssize_t recvlen =
-        recvfrom(socket_descriptor, buffer, (int)buffer_size, flags, address, address_length);
+    return teosockRecvfrom(
+        socket_descriptor, buffer, buffer_size, address, address_length, received_length, error_code);
 #else
-    ssize_t recvlen =
-        recvfrom(socket_descriptor, buffer, buffer_size, flags, address, address_length);
-#endif
+    struct iovec vector;
+    vector.iov_base = buffer;
+    vector.iov_len = buffer_size;
+
+    union {
+        // Dual-stack sockets may get control messages of both families for IPv4-mapped datagrams.
+        char buffer[CMSG_SPACE(sizeof(struct in6_pktinfo)) + CMSG_SPACE(sizeof(struct in_pktinfo)) +
+                    4 * CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = address;
+    header.msg_namelen = address_length != NULL ? *address_length : 0;
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+    ssize_t recvlen = recvmsg(socket_descriptor, &header, 0);
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountRecv(recvlen);
+    }
 
     if (recvlen == -1) {
-#if defined(TEONET_OS_WINDOWS)
-        int recv_errno = WSAGetLastError();
-#else
-        int recv_errno = errno;
-#endif
+        int recv_errno = teosockGetLastError();
+
         if (error_code != NULL) {
             *error_code = recv_errno;
         }
 
-        if (teosockRecvfromErrorIsRecoverable(recv_errno)) {
-            udp_recvfrom_result = TEOSOCK_RECVFROM_TRY_AGAIN;
-        } else if (teosockRecvfromErrorIsFatal(recv_errno)) {
-            udp_recvfrom_result = TEOSOCK_RECVFROM_FATAL_ERROR;
-        } else {
-            udp_recvfrom_result = TEOSOCK_RECVFROM_UNKNOWN_ERROR;
-        }
+        return teosockRecvfromErrorToResult(recv_errno);
     } else if (recvlen == 0) {
-        udp_recvfrom_result = TEOSOCK_RECVFROM_ORDERLY_CLOSED;
-    } else {
-        if (received_length != NULL) {
-            *received_length = (size_t)recvlen;
-        }
+        return TEOSOCK_RECVFROM_ORDERLY_CLOSED;
+    }
 
-        udp_recvfrom_result = TEOSOCK_RECVFROM_DATA_RECEIVED;
+    if (address_length != NULL) {
+        *address_length = header.msg_namelen;
     }
 
-    return udp_recvfrom_result;
+    for (struct cmsghdr* control_message = CMSG_FIRSTHDR(&header); control_message != NULL;
+         control_message = CMSG_NXTHDR(&header, control_message)) {
+        teosockParseDatagramInfo(control_message, info);
+    }
+
+    info->truncated = (header.msg_flags & MSG_CTRUNC) != 0;
+
+    if (received_length != NULL) {
+        *received_length = (size_t)recvlen;
+    }
+
+    return TEOSOCK_RECVFROM_DATA_RECEIVED;
+#endif
 }
 
-// Sends data on a connected socket.
-ssize_t teosockSend(teonetSocket socket_descriptor, const uint8_t* data, size_t length) {
+// Sends a datagram from specified local address.
+ssize_t teosockSendtoFrom(teonetSocket socket_descriptor, const uint8_t* data, size_t length,
+    const struct sockaddr* address, socklen_t address_length, const teosockDatagramInfo* source) {
 #if defined(TEONET_OS_WINDOWS)
-    if (length > (ssize_t)INT_MAX) {
-        // Can't send this much data.
+    if (length > (size_t)INT_MAX) {
+        // Can't send this much data in one datagram.
+        teosockSetLastError(WSAEMSGSIZE);
         return TEOSOCK_SOCKET_ERROR;
     }
 
-    return send(socket_descriptor, (const char*)data, (int)length, 0);
+    ssize_t result = sendto(socket_descriptor, (const char*)data, (int)length, 0, address, address_length);
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountSend(result, length);
+    }
+
+    return result;
+#else
+    struct iovec vector;
+    vector.iov_base = (void*)data;
+    vector.iov_len = length;
+
+    union {
+        char buffer[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = (void*)address;
+    header.msg_namelen = address_length;
+    header.msg_iov = &vector;
+    header.msg_iovlen = 1;
+
+    if (source != NULL && source->local_address_length != 0) {
+        header.msg_control = control.buffer;
+        struct cmsghdr* control_message = (struct cmsghdr*)control.buffer;
+
+        if (source->local_address.ss_family == AF_INET6) {
+            struct in6_pktinfo packet_info;
+            memset(&packet_info, 0, sizeof(packet_info));
+            packet_info.ipi6_addr = ((const struct sockaddr_in6*)&source->local_address)->sin6_addr;
+            packet_info.ipi6_ifindex = source->interface_index;
+
+            control_message->cmsg_level = IPPROTO_IPV6;
+            control_message->cmsg_type = IPV6_PKTINFO;
+            control_message->cmsg_len = CMSG_LEN(sizeof(packet_info));
+            memcpy(CMSG_DATA(control_message), &packet_info, sizeof(packet_info));
+            header.msg_controllen = CMSG_SPACE(sizeof(packet_info));
+        } else {
+#if defined(IP_PKTINFO)
+            struct in_pktinfo packet_info;
+            memset(&packet_info, 0, sizeof(packet_info));
+            packet_info.ipi_spec_dst = ((const struct sockaddr_in*)&source->local_address)->sin_addr;
+            packet_info.ipi_ifindex = (int)source->interface_index;
+
+            control_message->cmsg_level = IPPROTO_IP;
+            control_message->cmsg_type = IP_PKTINFO;
+            control_message->cmsg_len = CMSG_LEN(sizeof(packet_info));
+            memcpy(CMSG_DATA(control_message), &packet_info, sizeof(packet_info));
+            header.msg_controllen = CMSG_SPACE(sizeof(packet_info));
 #else
-    return write(socket_descriptor, data, length);
+            header.msg_control = NULL;
+#endif
+        }
+    }
+
+    ssize_t result = sendmsg(socket_descriptor, &header, 0);
+
+    if (teosockStatsEnabled) {
+        teosockStatsCountSend(result, length);
+    }
+
+    return result;
 #endif
 }
 
 // Determines the status of the socket, waiting if necessary, to perform synchronous operation.
 teosockSelectResult teosockSelect(teonetSocket socket_descriptor, int status_mask, int timeout_ms) {
+#if defined(TEONET_OS_WINDOWS)
     fd_set socket_fd_set;
     memset(&socket_fd_set, 0, sizeof(socket_fd_set));
 
@@ -394,12 +2677,51 @@ teosockSelectResult teosockSelect(teonetSocket socket_descriptor, int status_mas
 
     teosockTimevalFromMs(&timeval_timeout, timeout_ms);
 
-#if defined(TEONET_OS_WINDOWS)
+    int64_t start_time_us = teosockStatsEnabled ? teotimeGetMonotonicUs() : 0;
+
     int result = select(0, read_fd_set, write_fd_set, error_fd_set, &timeval_timeout);
 #else
-    int result = select(socket_descriptor + 1, read_fd_set, write_fd_set, error_fd_set, &timeval_timeout);
+    // poll() is used instead of select() to support descriptors above FD_SETSIZE.
+    // Errors and hangups are always reported by poll(), so TEOSOCK_SELECT_MODE_ERROR needs no flag.
+    struct pollfd descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.fd = socket_descriptor;
+
+    if (status_mask & TEOSOCK_SELECT_MODE_READ) {
+        descriptor.events |= POLLIN;
+    }
+
+    if (status_mask & TEOSOCK_SELECT_MODE_WRITE) {
+        descriptor.events |= POLLOUT;
+    }
+
+    // select() rejected negative timeout, keep it so instead of waiting infinitely.
+    if (timeout_ms < 0) {
+        errno = EINVAL;
+        return TEOSOCK_SELECT_ERROR;
+    }
+
+    int64_t start_time_us = teosockStatsEnabled ? teotimeGetMonotonicUs() : 0;
+
+    int result = poll(&descriptor, 1, timeout_ms);
+
+    // select() failed with EBADF on invalid descriptor, poll() reports it as event.
+    if (result > 0 && (descriptor.revents & POLLNVAL)) {
+        errno = EBADF;
+        result = TEOSOCK_SELECT_ERROR;
+    }
 #endif
 
+    if (teosockStatsEnabled) {
+        ++teosockThreadStats.select_calls;
+
+        teosockThreadStats.blocked_time_us += (uint64_t)(teotimeGetMonotonicUs() - start_time_us);
+
+        if (result == 0) {
+            ++teosockThreadStats.select_timeouts;
+        }
+    }
+
     // Make sure that return value is correct.
     if (result > 0) {
         result = TEOSOCK_SELECT_READY;
@@ -470,6 +2792,166 @@ int teosockSetTcpNodelay(teonetSocket socket_descriptor) {
     return result;
 }
 
+// Predefined socket tuning profiles.
+static const teosockProfile teosockProfiles[] = {
+    {
+        "low-latency",
+        1024 * 1024,  // receive_buffer_size
+        256 * 1024,  // send_buffer_size
+        false,  // force_buffer_size
+        50,  // busy_poll_us
+        1,  // tcp_nodelay
+        1,  // tcp_quickack
+        16 * 1024,  // tcp_notsent_lowat
+        0x10,  // type_of_service, IPTOS_LOWDELAY
+    },
+    {
+        "bulk-throughput",
+        4 * 1024 * 1024,  // receive_buffer_size
+        4 * 1024 * 1024,  // send_buffer_size
+        false,  // force_buffer_size
+        0,  // busy_poll_us
+        0,  // tcp_nodelay
+        TEOSOCK_PROFILE_KEEP,  // tcp_quickack
+        TEOSOCK_PROFILE_KEEP,  // tcp_notsent_lowat
+        0x08,  // type_of_service, IPTOS_THROUGHPUT
+    },
+};
+
+// Gets predefined socket tuning profile by name.
+const teosockProfile* teosockGetProfile(const char* name) {
+    for (size_t i = 0; i < sizeof(teosockProfiles) / sizeof(teosockProfiles[0]); ++i) {
+        if (strcmp(teosockProfiles[i].name, name) == 0) {
+            return &teosockProfiles[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Set integer socket option if value is not TEOSOCK_PROFILE_KEEP. Returns false on failure.
+static bool teosockProfileSetOption(teonetSocket socket_descriptor, int level, int option_name, int value) {
+    if (value == TEOSOCK_PROFILE_KEEP) {
+        return true;
+    }
+
+    return setsockopt(socket_descriptor, level, option_name, (const char*)&value, sizeof(value)) == 0;
+}
+
+#if defined(TEONET_OS_LINUX)
+// Set integer socket option which needs CAP_NET_ADMIN and kernel support. Lack of privilege or of kernel
+// support (ENOPROTOOPT) is not a failure, option keeps its previous value or stays unavailable which is
+// reported as effective one. Returns false on other failures.
+static bool teosockProfileSetPrivilegedOption(teonetSocket socket_descriptor, int level, int option_name, int value) {
+    if (teosockProfileSetOption(socket_descriptor, level, option_name, value)) {
+        return true;
+    }
+
+    return errno == EPERM || errno == ENOPROTOOPT;
+}
+#endif
+
+// Get integer socket option. Returns TEOSOCK_PROFILE_KEEP if option can't be read.
+static int teosockProfileGetOption(teonetSocket socket_descriptor, int level, int option_name) {
+    int value = 0;
+    socklen_t value_length = sizeof(value);
+
+    if (getsockopt(socket_descriptor, level, option_name, (char*)&value, &value_length) != 0) {
+        return TEOSOCK_PROFILE_KEEP;
+    }
+
+    return value;
+}
+
+// Set buffer size, using FORCE variant to exceed system limit if requested and permitted.
+static bool teosockProfileSetBufferSize(
+    teonetSocket socket_descriptor, int option_name, int force_option_name, int size, bool force) {
+    if (size == TEOSOCK_PROFILE_KEEP) {
+        return true;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    // Requires CAP_NET_ADMIN, fall back to regular option limited by net.core.[rw]mem_max.
+    if (force && teosockProfileSetOption(socket_descriptor, SOL_SOCKET, force_option_name, size)) {
+        return true;
+    }
+#endif
+
+    return teosockProfileSetOption(socket_descriptor, SOL_SOCKET, option_name, size);
+}
+
+// Applies socket tuning profile.
+int teosockApplyProfile(teonetSocket socket_descriptor, const teosockProfile* profile, teosockProfile* effective) {
+    bool success = true;
+
+    int socket_type = teosockProfileGetOption(socket_descriptor, SOL_SOCKET, SO_TYPE);
+    bool is_tcp = socket_type == SOCK_STREAM;
+
+    struct sockaddr_storage address;
+    socklen_t address_length = sizeof(address);
+    int family = AF_INET;
+    if (getsockname(socket_descriptor, (struct sockaddr*)&address, &address_length) == 0) {
+        family = address.ss_family;
+    }
+
+    int tos_level = family == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP;
+    int tos_option = family == AF_INET6 ? IPV6_TCLASS : IP_TOS;
+
+#if defined(TEONET_OS_LINUX)
+    int receive_force_option = SO_RCVBUFFORCE;
+    int send_force_option = SO_SNDBUFFORCE;
+#else
+    int receive_force_option = SO_RCVBUF;
+    int send_force_option = SO_SNDBUF;
+#endif
+
+    success &= teosockProfileSetBufferSize(socket_descriptor, SO_RCVBUF, receive_force_option,
+        profile->receive_buffer_size, profile->force_buffer_size);
+    success &= teosockProfileSetBufferSize(socket_descriptor, SO_SNDBUF, send_force_option,
+        profile->send_buffer_size, profile->force_buffer_size);
+    success &= teosockProfileSetOption(socket_descriptor, tos_level, tos_option, profile->type_of_service);
+
+#if defined(TEONET_OS_LINUX)
+    success &= teosockProfileSetPrivilegedOption(socket_descriptor, SOL_SOCKET, SO_BUSY_POLL, profile->busy_poll_us);
+#endif
+
+    if (is_tcp) {
+        success &= teosockProfileSetOption(socket_descriptor, IPPROTO_TCP, TCP_NODELAY, profile->tcp_nodelay);
+#if defined(TEONET_OS_LINUX)
+        success &= teosockProfileSetOption(socket_descriptor, IPPROTO_TCP, TCP_QUICKACK, profile->tcp_quickack);
+        success &= teosockProfileSetOption(
+            socket_descriptor, IPPROTO_TCP, TCP_NOTSENT_LOWAT, profile->tcp_notsent_lowat);
+#endif
+    }
+
+    if (effective != NULL) {
+        effective->name = profile->name;
+        effective->receive_buffer_size = teosockProfileGetOption(socket_descriptor, SOL_SOCKET, SO_RCVBUF);
+        effective->send_buffer_size = teosockProfileGetOption(socket_descriptor, SOL_SOCKET, SO_SNDBUF);
+        effective->force_buffer_size = profile->force_buffer_size;
+        effective->busy_poll_us = TEOSOCK_PROFILE_KEEP;
+        effective->tcp_nodelay = TEOSOCK_PROFILE_KEEP;
+        effective->tcp_quickack = TEOSOCK_PROFILE_KEEP;
+        effective->tcp_notsent_lowat = TEOSOCK_PROFILE_KEEP;
+        effective->type_of_service = teosockProfileGetOption(socket_descriptor, tos_level, tos_option);
+
+#if defined(TEONET_OS_LINUX)
+        effective->busy_poll_us = teosockProfileGetOption(socket_descriptor, SOL_SOCKET, SO_BUSY_POLL);
+#endif
+
+        if (is_tcp) {
+            effective->tcp_nodelay = teosockProfileGetOption(socket_descriptor, IPPROTO_TCP, TCP_NODELAY);
+#if defined(TEONET_OS_LINUX)
+            effective->tcp_quickack = teosockProfileGetOption(socket_descriptor, IPPROTO_TCP, TCP_QUICKACK);
+            effective->tcp_notsent_lowat =
+                teosockProfileGetOption(socket_descriptor, IPPROTO_TCP, TCP_NOTSENT_LOWAT);
+#endif
+        }
+    }
+
+    return success ? TEOSOCK_SOCKET_SUCCESS : TEOSOCK_SOCKET_ERROR;
+}
+
 // Initialize socket library.
 int teosockInit() {
 #if defined(TEONET_OS_WINDOWS)
@@ -0,0 +1,273 @@
+#include "teobase/stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if defined(TEONET_OS_WINDOWS)
+#include "teobase/windows.h"
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+struct teosockStream {
+    teonetSocket socket_descriptor;
+
+    // Write queue is a ring buffer, queued data starts at write_head.
+    uint8_t* write_buffer;
+    size_t write_capacity;
+    size_t write_head;
+    size_t write_length;
+    size_t flush_threshold;
+
+    // Read buffer is linear, unconsumed data is between read_start and read_end.
+    uint8_t* read_buffer;
+    size_t read_capacity;
+    size_t read_start;
+    size_t read_end;
+
+    bool cork;
+};
+
+// Set buffer descriptor.
+static void teosockStreamSetIovec(teosockIovec* iov, uint8_t* data, size_t length) {
+    iov->data = data;
+#if defined(TEONET_OS_WINDOWS)
+    iov->length = (ULONG)length;
+#else
+    iov->length = length;
+#endif
+}
+
+// Get descriptors of queued data, at most two because queue may wrap around.
+static size_t teosockStreamGetQueuedBuffers(const teosockStream* stream, teosockIovec* iov) {
+    if (stream->write_length == 0) {
+        return 0;
+    }
+
+    size_t first_length = stream->write_capacity - stream->write_head;
+    if (first_length >= stream->write_length) {
+        teosockStreamSetIovec(&iov[0], stream->write_buffer + stream->write_head, stream->write_length);
+        return 1;
+    }
+
+    teosockStreamSetIovec(&iov[0], stream->write_buffer + stream->write_head, first_length);
+    teosockStreamSetIovec(&iov[1], stream->write_buffer, stream->write_length - first_length);
+    return 2;
+}
+
+// Append data to write queue. Caller checks that data fits.
+static void teosockStreamAppend(teosockStream* stream, const uint8_t* data, size_t length) {
+    size_t tail = (stream->write_head + stream->write_length) % stream->write_capacity;
+    size_t first_length = stream->write_capacity - tail;
+
+    if (first_length >= length) {
+        memcpy(stream->write_buffer + tail, data, length);
+    } else {
+        memcpy(stream->write_buffer + tail, data, first_length);
+        memcpy(stream->write_buffer, data + first_length, length - first_length);
+    }
+
+    stream->write_length += length;
+}
+
+// Send queued data followed by extra data in one system call.
+// Amount of extra data which was sent is stored in extra_sent.
+static teosockStreamResult teosockStreamSendQueued(
+    teosockStream* stream, const uint8_t* extra, size_t extra_length, bool more, size_t* extra_sent) {
+    *extra_sent = 0;
+
+    teosockIovec iov[3];
+    size_t iov_count = teosockStreamGetQueuedBuffers(stream, iov);
+
+    if (extra_length != 0) {
+        teosockStreamSetIovec(&iov[iov_count++], (uint8_t*)extra, extra_length);
+    }
+
+    size_t total_length = stream->write_length + extra_length;
+
+    // Corked send keeps the last byte queued, so teosockStreamFlush() always has data
+    // to send without MSG_MORE, which pushes the partial segment held by the kernel.
+    if (more && total_length != 0) {
+        teosockIovec* last = &iov[iov_count - 1];
+        if (last->length == 1) {
+            --iov_count;
+        } else {
+            --last->length;
+        }
+
+        --total_length;
+    }
+
+    if (total_length == 0) {
+        return TEOSOCK_STREAM_SUCCESS;
+    }
+
+    ssize_t sent = teosockSendvFlags(stream->socket_descriptor, iov, iov_count, more ? TEOSOCK_SEND_MORE : 0);
+
+    if (sent < 0) {
+        if (!teosockRecvfromErrorIsRecoverable(teosockGetLastError())) {
+            return TEOSOCK_STREAM_ERROR;
+        }
+
+        sent = 0;
+    }
+
+    size_t sent_from_queue = (size_t)sent < stream->write_length ? (size_t)sent : stream->write_length;
+
+    stream->write_head = (stream->write_head + sent_from_queue) % stream->write_capacity;
+    stream->write_length -= sent_from_queue;
+    if (stream->write_length == 0) {
+        stream->write_head = 0;
+    }
+
+    *extra_sent = (size_t)sent - sent_from_queue;
+
+    return (size_t)sent == total_length ? TEOSOCK_STREAM_SUCCESS : TEOSOCK_STREAM_PENDING;
+}
+
+// Creates a buffered stream on a connected socket.
+teosockStream* teosockStreamCreate(
+    teonetSocket socket_descriptor, size_t write_buffer_size, size_t read_buffer_size, size_t flush_threshold) {
+    if (write_buffer_size == 0 || read_buffer_size == 0) {
+        return NULL;
+    }
+
+    teosockStream* stream = calloc(1, sizeof(teosockStream));
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    stream->write_buffer = malloc(write_buffer_size);
+    stream->read_buffer = malloc(read_buffer_size);
+
+    if (stream->write_buffer == NULL || stream->read_buffer == NULL) {
+        teosockStreamDestroy(stream);
+        return NULL;
+    }
+
+    stream->socket_descriptor = socket_descriptor;
+    stream->write_capacity = write_buffer_size;
+    stream->read_capacity = read_buffer_size;
+    stream->flush_threshold = flush_threshold;
+
+    return stream;
+}
+
+// Destroys a stream.
+void teosockStreamDestroy(teosockStream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+
+    free(stream->write_buffer);
+    free(stream->read_buffer);
+    free(stream);
+}
+
+// Enables corking of sends triggered by flush threshold.
+void teosockStreamSetCork(teosockStream* stream, bool enabled) {
+#if defined(TEONET_OS_LINUX)
+    stream->cork = enabled;
+#endif
+}
+
+// Queues data for sending.
+teosockStreamResult teosockStreamWrite(teosockStream* stream, const uint8_t* data, size_t length) {
+    size_t extra_sent = 0;
+
+    if (stream->write_length + length > stream->write_capacity) {
+        // Make room by sending queued data, this message follows it.
+        if (teosockStreamSendQueued(stream, NULL, 0, stream->cork, &extra_sent) == TEOSOCK_STREAM_ERROR) {
+            return TEOSOCK_STREAM_ERROR;
+        }
+
+        if (stream->write_length + length > stream->write_capacity) {
+            return TEOSOCK_STREAM_BUFFER_FULL;
+        }
+    }
+
+    if (stream->write_length + length >= stream->flush_threshold) {
+        // Send queue and new message together, without copying the message.
+        if (teosockStreamSendQueued(stream, data, length, stream->cork, &extra_sent) == TEOSOCK_STREAM_ERROR) {
+            return TEOSOCK_STREAM_ERROR;
+        }
+
+        data += extra_sent;
+        length -= extra_sent;
+    }
+
+    if (length != 0) {
+        teosockStreamAppend(stream, data, length);
+    }
+
+    return TEOSOCK_STREAM_SUCCESS;
+}
+
+// Sends all queued data.
+teosockStreamResult teosockStreamFlush(teosockStream* stream) {
+    size_t extra_sent = 0;
+
+    return teosockStreamSendQueued(stream, NULL, 0, false, &extra_sent);
+}
+
+// Gets amount of queued data which was not sent yet.
+size_t teosockStreamGetPendingLength(const teosockStream* stream) {
+    return stream->write_length;
+}
+
+// Reads available data from socket into read buffer.
+teosockStreamResult teosockStreamFill(teosockStream* stream, size_t* received_length) {
+    if (stream->read_start == stream->read_end) {
+        stream->read_start = 0;
+        stream->read_end = 0;
+    } else if (stream->read_start != 0 && stream->read_capacity - stream->read_end < stream->read_capacity / 2) {
+        // Move unconsumed data to the beginning to keep large free space for reading.
+        memmove(stream->read_buffer, stream->read_buffer + stream->read_start, stream->read_end - stream->read_start);
+        stream->read_end -= stream->read_start;
+        stream->read_start = 0;
+    }
+
+    if (stream->read_end == stream->read_capacity) {
+        return TEOSOCK_STREAM_BUFFER_FULL;
+    }
+
+    ssize_t received = teosockRecv(
+        stream->socket_descriptor, stream->read_buffer + stream->read_end, stream->read_capacity - stream->read_end);
+
+    if (received < 0) {
+        bool would_block = teosockRecvfromErrorIsRecoverable(teosockGetLastError());
+        return would_block ? TEOSOCK_STREAM_PENDING : TEOSOCK_STREAM_ERROR;
+    } else if (received == 0) {
+        return TEOSOCK_STREAM_CLOSED;
+    }
+
+    stream->read_end += (size_t)received;
+
+    if (received_length != NULL) {
+        *received_length = (size_t)received;
+    }
+
+    return TEOSOCK_STREAM_SUCCESS;
+}
+
+// Gets received data which was not consumed yet.
+const uint8_t* teosockStreamPeek(const teosockStream* stream, size_t* length) {
+    *length = stream->read_end - stream->read_start;
+
+    return stream->read_buffer + stream->read_start;
+}
+
+// Marks received data as processed.
+void teosockStreamConsume(teosockStream* stream, size_t length) {
+    size_t available = stream->read_end - stream->read_start;
+    if (length > available) {
+        length = available;
+    }
+
+    stream->read_start += length;
+}
@@ -1,5 +1,6 @@
 #include "teobase/time.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "teobase/types.h"
@@ -7,12 +8,75 @@
 #include "teobase/platform.h"
 
 #if defined(TEONET_OS_WINDOWS)
+#include "teobase/windows.h"
 #include <sys/types.h>
 #include <sys/timeb.h>
 #else
 #include <sys/time.h>
+#include <time.h>
 #endif
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TEOTIME_CYCLES_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+#define TEOTIME_CYCLES_ARM
+#endif
+
+#if defined(_MSC_VER)
+#define TEOTIME_ATOMIC_LOAD(value) (*(value))
+#define TEOTIME_ATOMIC_STORE(value, new_value) InterlockedExchange((volatile LONG*)(value), (new_value))
+#define TEOTIME_ATOMIC_CLAIM(value, expected, new_value) \
+    (InterlockedCompareExchange((volatile LONG*)(value), (new_value), (expected)) == (expected))
+#else
+#define TEOTIME_ATOMIC_LOAD(value) __atomic_load_n((value), __ATOMIC_ACQUIRE)
+#define TEOTIME_ATOMIC_STORE(value, new_value) __atomic_store_n((value), (new_value), __ATOMIC_RELEASE)
+#define TEOTIME_ATOMIC_CLAIM(value, expected, new_value) \
+    __sync_bool_compare_and_swap((value), (expected), (new_value))
+#endif
+
+#if defined(_MSC_VER)
+#define TEOTIME_THREAD_LOCAL __declspec(thread)
+#else
+#define TEOTIME_THREAD_LOCAL __thread
+#endif
+
+// Duration of cycle counter calibration.
+#define TEOTIME_CYCLES_CALIBRATION_NS (10 * NANOSECONDS_IN_MILLISECOND)
+
+// Calibrated frequencies outside of this range mean that counter is broken.
+#define TEOTIME_CYCLES_MIN_FREQUENCY 100000000LL
+#define TEOTIME_CYCLES_MAX_FREQUENCY 100000000000LL
+
+// States of cycle counter calibration.
+enum {
+    TEOTIME_CYCLES_UNCALIBRATED = 0,
+    TEOTIME_CYCLES_CALIBRATING = 1,
+    TEOTIME_CYCLES_CALIBRATED = 2,
+};
+
+static volatile int32_t teotime_cycles_state = TEOTIME_CYCLES_UNCALIBRATED;
+static teotimeCyclesSource teotime_cycles_source = TEOTIME_CYCLES_MONOTONIC;
+static int64_t teotime_cycles_frequency = NANOSECONDS_IN_SECOND;
+static double teotime_ns_per_cycle = 1.0;
+static bool teotime_cycles_rdtscp = false;
+
+// Cached time of thread, stored in all units so that reading needs no division.
+typedef struct teotimeCachedTime {
+    int64_t now_ns;
+    int64_t now_us;
+    int64_t now_ms;
+    teotimeCachedTimeSource source;
+    bool valid;
+} teotimeCachedTime;
+
+static TEOTIME_THREAD_LOCAL teotimeCachedTime teotime_cached_time;
+
 // Get current time in microseconds.
 int64_t teotimeGetCurrentTimeUs() {
     int64_t current_time_us;
@@ -74,3 +138,309 @@ int64_t teotimeGetTimePassedMs(int64_t time_value_ms) {
 
     return current_time_ms - time_value_ms;
 }
+
+// Get monotonic time in nanoseconds.
+int64_t teotimeGetMonotonicNs() {
+#if defined(TEONET_OS_WINDOWS)
+    // Frequency is fixed at system boot, racing initialization stores the same value.
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    // Split conversion to avoid overflow of counter multiplied by nanoseconds.
+    int64_t seconds = counter.QuadPart / frequency.QuadPart;
+    int64_t remainder = counter.QuadPart % frequency.QuadPart;
+
+    return seconds * NANOSECONDS_IN_SECOND + remainder * NANOSECONDS_IN_SECOND / frequency.QuadPart;
+#else
+    struct timespec time_value;
+    memset(&time_value, 0, sizeof(time_value));
+
+    clock_gettime(CLOCK_MONOTONIC, &time_value);
+
+    // Cast to int64_t is needed on 32-bit Unix systems.
+    return (int64_t)time_value.tv_sec * NANOSECONDS_IN_SECOND + time_value.tv_nsec;
+#endif
+}
+
+// Get monotonic time in microseconds.
+int64_t teotimeGetMonotonicUs() {
+    return teotimeGetMonotonicNs() / NANOSECONDS_IN_MICROSECOND;
+}
+
+// Get monotonic time in milliseconds.
+int64_t teotimeGetMonotonicMs() {
+    return teotimeGetMonotonicNs() / NANOSECONDS_IN_MILLISECOND;
+}
+
+// Read processor counter without calibration checks.
+static int64_t teotimeReadCounter(void) {
+#if defined(TEOTIME_CYCLES_X86)
+    return (int64_t)__rdtsc();
+#elif defined(TEOTIME_CYCLES_ARM)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return (int64_t)value;
+#else
+    return teotimeGetMonotonicNs();
+#endif
+}
+
+#if defined(TEOTIME_CYCLES_X86)
+// Execute cpuid instruction, returns false if leaf is not supported.
+static bool teotimeCpuid(unsigned int leaf, unsigned int registers[4]) {
+#if defined(_MSC_VER)
+    int max_registers[4];
+    __cpuid(max_registers, (int)(leaf & 0x80000000U));
+    if ((unsigned int)max_registers[0] < leaf) {
+        return false;
+    }
+
+    __cpuid((int*)registers, (int)leaf);
+    return true;
+#else
+    return __get_cpuid(leaf, &registers[0], &registers[1], &registers[2], &registers[3]) != 0;
+#endif
+}
+
+// Check that time stamp counter runs at constant rate in all power states and is trusted by the kernel.
+static bool teotimeTscIsReliable(void) {
+    unsigned int registers[4] = {0, 0, 0, 0};
+
+    // Invariant TSC bit.
+    if (!teotimeCpuid(0x80000007U, registers) || (registers[3] & (1U << 8)) == 0) {
+        return false;
+    }
+
+    // RDTSCP instruction bit.
+    if (teotimeCpuid(0x80000001U, registers)) {
+        teotime_cycles_rdtscp = (registers[3] & (1U << 27)) != 0;
+    }
+
+#if defined(TEONET_OS_LINUX)
+    // Kernel removes TSC from available clock sources when it finds TSC unsynchronized between cores.
+    FILE* clocksource_file = fopen("/sys/devices/system/clocksource/clocksource0/available_clocksource", "r");
+    if (clocksource_file != NULL) {
+        char clocksources[256] = {0};
+        bool has_tsc = fgets(clocksources, sizeof(clocksources), clocksource_file) != NULL &&
+                       strstr(clocksources, "tsc") != NULL;
+        fclose(clocksource_file);
+
+        if (!has_tsc) {
+            return false;
+        }
+    }
+#endif
+
+    return true;
+}
+#endif
+
+// Measure counter frequency against monotonic clock, returns zero if counter is broken.
+static int64_t teotimeMeasureCounterFrequency(void) {
+    int64_t start_time_ns = teotimeGetMonotonicNs();
+    int64_t start_cycles = teotimeReadCounter();
+
+    int64_t end_time_ns;
+    do {
+        end_time_ns = teotimeGetMonotonicNs();
+    } while (end_time_ns - start_time_ns < TEOTIME_CYCLES_CALIBRATION_NS);
+
+    int64_t end_cycles = teotimeReadCounter();
+
+    if (end_cycles <= start_cycles) {
+        return 0;
+    }
+
+    int64_t frequency =
+        (int64_t)((double)(end_cycles - start_cycles) * NANOSECONDS_IN_SECOND / (double)(end_time_ns - start_time_ns));
+
+    if (frequency < TEOTIME_CYCLES_MIN_FREQUENCY || frequency > TEOTIME_CYCLES_MAX_FREQUENCY) {
+        return 0;
+    }
+
+    return frequency;
+}
+
+// Select cycle counter source and measure its frequency.
+static void teotimeCalibrateCyclesOnce(void) {
+    teotimeCyclesSource source = TEOTIME_CYCLES_MONOTONIC;
+    int64_t frequency = 0;
+
+#if defined(TEOTIME_CYCLES_X86)
+    if (teotimeTscIsReliable()) {
+        frequency = teotimeMeasureCounterFrequency();
+        source = TEOTIME_CYCLES_TSC;
+    }
+#elif defined(TEOTIME_CYCLES_ARM)
+    // Counter frequency is reported by processor, no need to measure it.
+    uint64_t counter_frequency;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(counter_frequency));
+    frequency = (int64_t)counter_frequency;
+    source = TEOTIME_CYCLES_ARM_COUNTER;
+#endif
+
+    if (frequency == 0) {
+        source = TEOTIME_CYCLES_MONOTONIC;
+        frequency = NANOSECONDS_IN_SECOND;
+    }
+
+    teotime_cycles_source = source;
+    teotime_cycles_frequency = frequency;
+    teotime_ns_per_cycle = (double)NANOSECONDS_IN_SECOND / (double)frequency;
+}
+
+// Calibrates cycle counter against monotonic clock.
+void teotimeCalibrateCycles() {
+    if (TEOTIME_ATOMIC_LOAD(&teotime_cycles_state) == TEOTIME_CYCLES_CALIBRATED) {
+        return;
+    }
+
+    if (TEOTIME_ATOMIC_CLAIM(&teotime_cycles_state, TEOTIME_CYCLES_UNCALIBRATED, TEOTIME_CYCLES_CALIBRATING)) {
+        teotimeCalibrateCyclesOnce();
+        TEOTIME_ATOMIC_STORE(&teotime_cycles_state, TEOTIME_CYCLES_CALIBRATED);
+        return;
+    }
+
+    // Other thread is calibrating, wait for its result.
+    while (TEOTIME_ATOMIC_LOAD(&teotime_cycles_state) != TEOTIME_CYCLES_CALIBRATED) {
+    }
+}
+
+// Get cycle counter value.
+int64_t teotimeGetCycles() {
+    if (TEOTIME_ATOMIC_LOAD(&teotime_cycles_state) != TEOTIME_CYCLES_CALIBRATED) {
+        teotimeCalibrateCycles();
+    }
+
+    if (teotime_cycles_source == TEOTIME_CYCLES_MONOTONIC) {
+        return teotimeGetMonotonicNs();
+    }
+
+    return teotimeReadCounter();
+}
+
+// Get cycle counter value after all preceding instructions completed.
+int64_t teotimeGetCyclesOrdered() {
+    if (TEOTIME_ATOMIC_LOAD(&teotime_cycles_state) != TEOTIME_CYCLES_CALIBRATED) {
+        teotimeCalibrateCycles();
+    }
+
+    if (teotime_cycles_source == TEOTIME_CYCLES_MONOTONIC) {
+        return teotimeGetMonotonicNs();
+    }
+
+#if defined(TEOTIME_CYCLES_X86)
+    if (teotime_cycles_rdtscp) {
+        unsigned int processor_id;
+        return (int64_t)__rdtscp(&processor_id);
+    }
+
+    _mm_lfence();
+#elif defined(TEOTIME_CYCLES_ARM)
+    __asm__ volatile("isb" ::: "memory");
+#endif
+
+    return teotimeReadCounter();
+}
+
+// Get source of cycle counter values.
+teotimeCyclesSource teotimeGetCyclesSource() {
+    teotimeCalibrateCycles();
+
+    return teotime_cycles_source;
+}
+
+// Get cycle counter frequency.
+int64_t teotimeGetCyclesFrequency() {
+    teotimeCalibrateCycles();
+
+    return teotime_cycles_frequency;
+}
+
+// Convert amount of cycles to nanoseconds.
+int64_t teotimeCyclesToNs(int64_t cycles) {
+    teotimeCalibrateCycles();
+
+    return (int64_t)((double)cycles * teotime_ns_per_cycle);
+}
+
+// Convert amount of cycles to microseconds.
+int64_t teotimeCyclesToUs(int64_t cycles) {
+    return teotimeCyclesToNs(cycles) / NANOSECONDS_IN_MICROSECOND;
+}
+
+// Convert nanoseconds to amount of cycles.
+int64_t teotimeNsToCycles(int64_t time_ns) {
+    teotimeCalibrateCycles();
+
+    return (int64_t)((double)time_ns / teotime_ns_per_cycle);
+}
+
+// Selects clock used to refresh cached time of the calling thread.
+void teotimeSetCachedTimeSource(teotimeCachedTimeSource source) {
+    teotime_cached_time.source = source;
+}
+
+// Reads clock and stores the result as cached time of the calling thread.
+int64_t teotimeRefreshCachedTime() {
+    int64_t now_ns;
+
+#if defined(TEONET_OS_LINUX) && defined(CLOCK_MONOTONIC_COARSE)
+    if (teotime_cached_time.source == TEOTIME_CACHED_MONOTONIC_COARSE) {
+        struct timespec time_value;
+        memset(&time_value, 0, sizeof(time_value));
+
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &time_value);
+
+        now_ns = (int64_t)time_value.tv_sec * NANOSECONDS_IN_SECOND + time_value.tv_nsec;
+    } else {
+        now_ns = teotimeGetMonotonicNs();
+    }
+#else
+    now_ns = teotimeGetMonotonicNs();
+#endif
+
+    // Coarse and precise clocks may disagree slightly, cached time never goes back.
+    if (teotime_cached_time.valid && now_ns < teotime_cached_time.now_ns) {
+        return teotime_cached_time.now_ns;
+    }
+
+    teotime_cached_time.now_ns = now_ns;
+    teotime_cached_time.now_us = now_ns / NANOSECONDS_IN_MICROSECOND;
+    teotime_cached_time.now_ms = now_ns / NANOSECONDS_IN_MILLISECOND;
+    teotime_cached_time.valid = true;
+
+    return now_ns;
+}
+
+// Get cached monotonic time of the calling thread in nanoseconds.
+int64_t teotimeGetCachedTimeNs() {
+    if (!teotime_cached_time.valid) {
+        teotimeRefreshCachedTime();
+    }
+
+    return teotime_cached_time.now_ns;
+}
+
+// Get cached monotonic time of the calling thread in microseconds.
+int64_t teotimeGetCachedTimeUs() {
+    if (!teotime_cached_time.valid) {
+        teotimeRefreshCachedTime();
+    }
+
+    return teotime_cached_time.now_us;
+}
+
+// Get cached monotonic time of the calling thread in milliseconds.
+int64_t teotimeGetCachedTimeMs() {
+    if (!teotime_cached_time.valid) {
+        teotimeRefreshCachedTime();
+    }
+
+    return teotime_cached_time.now_ms;
+}
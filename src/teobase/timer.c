@@ -0,0 +1,378 @@
+#include "teobase/timer.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "teobase/time.h"
+
+// First level has a slot per tick.
+#define TEOTIMER_ROOT_BITS 8
+#define TEOTIMER_ROOT_SLOTS (1 << TEOTIMER_ROOT_BITS)
+
+// Other levels have slots 64 times wider than previous level.
+#define TEOTIMER_LEVEL_BITS 6
+#define TEOTIMER_LEVEL_SLOTS (1 << TEOTIMER_LEVEL_BITS)
+#define TEOTIMER_LEVELS_COUNT 4
+
+#define TEOTIMER_SLOTS_COUNT (TEOTIMER_ROOT_SLOTS + TEOTIMER_LEVELS_COUNT * TEOTIMER_LEVEL_SLOTS)
+
+// Timers further than wheel covers are kept in the last level and moved around until they expire.
+#define TEOTIMER_MAX_DELTA ((INT64_C(1) << (TEOTIMER_ROOT_BITS + TEOTIMER_LEVELS_COUNT * TEOTIMER_LEVEL_BITS)) - 1)
+
+struct teotimerWheel {
+    int64_t tick_ms;
+    int64_t current_tick;  // The next tick to process.
+    size_t count;
+
+    // Bit is set for each non-empty slot, used to find the next expiration without scanning lists.
+    uint64_t occupied[TEOTIMER_SLOTS_COUNT / 64];
+    teotimer* slots[TEOTIMER_SLOTS_COUNT];
+};
+
+// Get index of the first slot of level, level zero is the first level.
+static size_t teotimerLevelStart(int level) {
+    return level == 0 ? 0 : TEOTIMER_ROOT_SLOTS + (size_t)(level - 1) * TEOTIMER_LEVEL_SLOTS;
+}
+
+// Get amount of bits tick is shifted to get slot index of level.
+static int teotimerLevelShift(int level) {
+    return level == 0 ? 0 : TEOTIMER_ROOT_BITS + (level - 1) * TEOTIMER_LEVEL_BITS;
+}
+
+// Get amount of slots in level.
+static size_t teotimerLevelSize(int level) {
+    return level == 0 ? TEOTIMER_ROOT_SLOTS : TEOTIMER_LEVEL_SLOTS;
+}
+
+// Get index of the lowest set bit, value must not be zero.
+static int teotimerLowestBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Find the first non-empty slot of level in circular order starting from start index, returns -1 if level is empty.
+static int teotimerFindSlot(const teotimerWheel* wheel, int level, size_t start) {
+    size_t first_slot = teotimerLevelStart(level);
+    size_t level_size = teotimerLevelSize(level);
+
+    // Search [start, level_size) and then [0, start).
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t from = pass == 0 ? start : 0;
+        size_t to = pass == 0 ? level_size : start;
+
+        size_t position = from;
+        while (position < to) {
+            size_t bit = first_slot + position;
+            uint64_t word = wheel->occupied[bit / 64] >> (bit % 64);
+
+            if (word != 0) {
+                size_t found = position + (size_t)teotimerLowestBit(word);
+                return found < to ? (int)found : -1;
+            }
+
+            // Skip to the start of the next word, levels are aligned to words.
+            position += 64 - bit % 64;
+        }
+    }
+
+    return -1;
+}
+
+// Add timer to the head of slot list.
+static void teotimerLink(teotimerWheel* wheel, size_t slot, teotimer* timer) {
+    timer->next = wheel->slots[slot];
+    if (timer->next != NULL) {
+        timer->next->pprev = &timer->next;
+    }
+
+    wheel->slots[slot] = timer;
+    timer->pprev = &wheel->slots[slot];
+
+    wheel->occupied[slot / 64] |= UINT64_C(1) << (slot % 64);
+}
+
+// Remove timer from list it belongs to.
+static void teotimerUnlink(teotimerWheel* wheel, teotimer* timer) {
+    teotimer** pprev = timer->pprev;
+
+    *pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = pprev;
+    }
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+
+    // Timer may be in detached list of expired timers, which is not a slot.
+    if (pprev >= &wheel->slots[0] && pprev < &wheel->slots[TEOTIMER_SLOTS_COUNT] && *pprev == NULL) {
+        size_t slot = (size_t)(pprev - &wheel->slots[0]);
+        wheel->occupied[slot / 64] &= ~(UINT64_C(1) << (slot % 64));
+    }
+}
+
+// Put timer into slot matching its expiration tick.
+static void teotimerPlace(teotimerWheel* wheel, teotimer* timer) {
+    int64_t expires_tick = timer->expires_tick;
+    int64_t delta = expires_tick - wheel->current_tick;
+
+    if (delta < 0) {
+        // Expired timer goes to slot processed next.
+        teotimerLink(wheel, (size_t)(wheel->current_tick & (TEOTIMER_ROOT_SLOTS - 1)), timer);
+        return;
+    }
+
+    if (delta > TEOTIMER_MAX_DELTA) {
+        expires_tick = wheel->current_tick + TEOTIMER_MAX_DELTA;
+        delta = TEOTIMER_MAX_DELTA;
+    }
+
+    if (delta < TEOTIMER_ROOT_SLOTS) {
+        teotimerLink(wheel, (size_t)(expires_tick & (TEOTIMER_ROOT_SLOTS - 1)), timer);
+        return;
+    }
+
+    for (int level = 1; level <= TEOTIMER_LEVELS_COUNT; ++level) {
+        int shift = teotimerLevelShift(level);
+
+        if (level == TEOTIMER_LEVELS_COUNT || delta < (INT64_C(1) << (shift + TEOTIMER_LEVEL_BITS))) {
+            size_t index = (size_t)((expires_tick >> shift) & (TEOTIMER_LEVEL_SLOTS - 1));
+            teotimerLink(wheel, teotimerLevelStart(level) + index, timer);
+            return;
+        }
+    }
+}
+
+// Move timers of slot to lower levels.
+static void teotimerCascade(teotimerWheel* wheel, size_t slot) {
+    teotimer* timer = wheel->slots[slot];
+
+    wheel->slots[slot] = NULL;
+    wheel->occupied[slot / 64] &= ~(UINT64_C(1) << (slot % 64));
+
+    while (timer != NULL) {
+        teotimer* next = timer->next;
+        teotimerPlace(wheel, timer);
+        timer = next;
+    }
+}
+
+// Expire timers of current tick and move to the next tick.
+static size_t teotimerRunTick(teotimerWheel* wheel) {
+    int64_t tick = wheel->current_tick;
+    size_t root_index = (size_t)(tick & (TEOTIMER_ROOT_SLOTS - 1));
+
+    // Cascade levels whose slot boundary is reached, lower levels first.
+    if (root_index == 0) {
+        for (int level = 1; level <= TEOTIMER_LEVELS_COUNT; ++level) {
+            size_t index = (size_t)((tick >> teotimerLevelShift(level)) & (TEOTIMER_LEVEL_SLOTS - 1));
+            teotimerCascade(wheel, teotimerLevelStart(level) + index);
+
+            if (index != 0) {
+                break;
+            }
+        }
+    }
+
+    // Detach expired list, so that callbacks can cancel timers in it and start timers for the next tick.
+    teotimer* expired = wheel->slots[root_index];
+    wheel->slots[root_index] = NULL;
+    wheel->occupied[root_index / 64] &= ~(UINT64_C(1) << (root_index % 64));
+
+    if (expired != NULL) {
+        expired->pprev = &expired;
+    }
+
+    wheel->current_tick = tick + 1;
+
+    size_t expired_count = 0;
+
+    while (expired != NULL) {
+        teotimer* timer = expired;
+        teotimerUnlink(wheel, timer);
+        --wheel->count;
+        ++expired_count;
+
+        timer->callback(wheel, timer, timer->user_data);
+    }
+
+    return expired_count;
+}
+
+// Creates a timing wheel.
+teotimerWheel* teotimerWheelCreate(int64_t tick_ms) {
+    if (tick_ms <= 0) {
+        return NULL;
+    }
+
+    teotimerWheel* wheel = calloc(1, sizeof(teotimerWheel));
+    if (wheel == NULL) {
+        return NULL;
+    }
+
+    wheel->tick_ms = tick_ms;
+    wheel->current_tick = teotimeGetMonotonicMs() / tick_ms;
+
+    return wheel;
+}
+
+// Destroys a timing wheel.
+void teotimerWheelDestroy(teotimerWheel* wheel) {
+    if (wheel == NULL) {
+        return;
+    }
+
+    // Mark dropped timers as not pending, so that their owners can reuse them.
+    for (size_t slot = 0; slot < TEOTIMER_SLOTS_COUNT; ++slot) {
+        while (wheel->slots[slot] != NULL) {
+            teotimerUnlink(wheel, wheel->slots[slot]);
+        }
+    }
+
+    free(wheel);
+}
+
+// Initializes a timer.
+void teotimerInit(teotimer* timer, teotimerCallback callback, void* user_data) {
+    memset(timer, 0, sizeof(teotimer));
+    timer->callback = callback;
+    timer->user_data = user_data;
+}
+
+// Starts a timer.
+void teotimerStart(teotimerWheel* wheel, teotimer* timer, int64_t delay_ms) {
+    if (timer->pprev != NULL) {
+        teotimerUnlink(wheel, timer);
+    } else {
+        ++wheel->count;
+    }
+
+    int64_t now_ms = teotimeGetMonotonicMs();
+
+    if (delay_ms < 0) {
+        delay_ms = 0;
+    } else if (delay_ms > INT64_MAX - now_ms) {
+        // Such timer never expires anyway, keep expiration time representable.
+        delay_ms = INT64_MAX - now_ms;
+    }
+
+    // Round up, so that timer never expires earlier than requested.
+    int64_t expires_ms = now_ms + delay_ms;
+    timer->expires_tick = expires_ms / wheel->tick_ms + (expires_ms % wheel->tick_ms != 0 ? 1 : 0);
+
+    teotimerPlace(wheel, timer);
+}
+
+// Cancels a timer.
+bool teotimerCancel(teotimerWheel* wheel, teotimer* timer) {
+    if (timer->pprev == NULL) {
+        return false;
+    }
+
+    teotimerUnlink(wheel, timer);
+    --wheel->count;
+
+    return true;
+}
+
+// Checks if timer is started and did not expire yet.
+bool teotimerIsPending(const teotimer* timer) {
+    return timer->pprev != NULL;
+}
+
+// Calls callbacks of all expired timers.
+size_t teotimerWheelProcess(teotimerWheel* wheel) {
+    int64_t now_tick = teotimeGetMonotonicMs() / wheel->tick_ms;
+    size_t expired_count = 0;
+
+    while (wheel->current_tick <= now_tick) {
+        if (wheel->count == 0) {
+            // Nothing can expire, skip idle ticks at once.
+            wheel->current_tick = now_tick + 1;
+            break;
+        }
+
+        expired_count += teotimerRunTick(wheel);
+    }
+
+    return expired_count;
+}
+
+// Gets time until the next timer expires.
+int teotimerWheelGetTimeout(teotimerWheel* wheel) {
+    if (wheel->count == 0) {
+        return -1;
+    }
+
+    int64_t current_tick = wheel->current_tick;
+    int64_t next_tick = INT64_MAX;
+
+    // Timers of the first level expire exactly at their slot.
+    size_t root_index = (size_t)(current_tick & (TEOTIMER_ROOT_SLOTS - 1));
+    int root_slot = teotimerFindSlot(wheel, 0, root_index);
+
+    if (root_slot >= 0) {
+        next_tick = current_tick + (int64_t)(((size_t)root_slot - root_index) & (TEOTIMER_ROOT_SLOTS - 1));
+    }
+
+    // Timers of other levels expire not earlier than their slot is cascaded.
+    for (int level = 1; level <= TEOTIMER_LEVELS_COUNT; ++level) {
+        int shift = teotimerLevelShift(level);
+        size_t level_index = (size_t)((current_tick >> shift) & (TEOTIMER_LEVEL_SLOTS - 1));
+
+        // Slot of current index is cascaded at current tick if it is on slot boundary, otherwise after full turn.
+        bool on_boundary = (current_tick & ((INT64_C(1) << shift) - 1)) == 0;
+        size_t start = on_boundary ? level_index : (level_index + 1) & (TEOTIMER_LEVEL_SLOTS - 1);
+
+        int slot = teotimerFindSlot(wheel, level, start);
+        if (slot < 0) {
+            continue;
+        }
+
+        int64_t distance = (int64_t)(((size_t)slot - level_index) & (TEOTIMER_LEVEL_SLOTS - 1));
+        if (distance == 0 && !on_boundary) {
+            distance = TEOTIMER_LEVEL_SLOTS;
+        }
+
+        int64_t cascade_tick = ((current_tick >> shift) + distance) << shift;
+        if (cascade_tick < next_tick) {
+            next_tick = cascade_tick;
+        }
+    }
+
+    // Nothing found in slots while timers are counted means callback of expired timer is running
+    // and the rest of expired list is about to be processed.
+    if (next_tick == INT64_MAX) {
+        return 0;
+    }
+
+    if (next_tick > INT64_MAX / wheel->tick_ms) {
+        return INT_MAX;
+    }
+
+    int64_t timeout_ms = next_tick * wheel->tick_ms - teotimeGetMonotonicMs();
+
+    if (timeout_ms < 0) {
+        return 0;
+    }
+
+    return timeout_ms > INT_MAX ? INT_MAX : (int)timeout_ms;
+}
+
+// Gets amount of pending timers.
+size_t teotimerWheelGetCount(const teotimerWheel* wheel) {
+    return wheel->count;
+}
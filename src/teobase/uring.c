@@ -0,0 +1,364 @@
+#include "teobase/uring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "teobase/types.h"
+
+#include "teobase/platform.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "teobase/logging.h"
+
+struct teosockUring {
+    int ring_descriptor;
+
+    // Submission queue ring shared with the kernel.
+    void* sq_ring;
+    size_t sq_ring_size;
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int* sq_array;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    // Tail of locally prepared entries and amount of entries not yet passed to the kernel.
+    unsigned int sq_local_tail;
+    unsigned int sq_pending;
+
+    // Completion queue ring shared with the kernel.
+    void* cq_ring;
+    size_t cq_ring_size;
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    unsigned int cq_mask;
+    struct io_uring_cqe* cqes;
+};
+
+static int teosockUringSetup(unsigned int entries, struct io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int teosockUringEnter(int ring_descriptor, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return (int)syscall(__NR_io_uring_enter, ring_descriptor, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int teosockUringRegister(int ring_descriptor, unsigned int opcode, const void* arguments, unsigned int count) {
+    return (int)syscall(__NR_io_uring_register, ring_descriptor, opcode, arguments, count);
+}
+
+// Creates an io_uring instance.
+teosockUring* teosockUringCreate(unsigned int entries) {
+    teosockUring* uring = calloc(1, sizeof(teosockUring));
+
+    if (uring == NULL) {
+        return NULL;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    uring->ring_descriptor = teosockUringSetup(entries, &params);
+
+    if (uring->ring_descriptor == -1) {
+        LTRACK_E("TeoBase", "Failed to setup io_uring. Error code: %d.", errno);
+        free(uring);
+        return NULL;
+    }
+
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // Both rings can be mapped at once on kernels with IORING_FEAT_SINGLE_MMAP.
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        if (uring->cq_ring_size > uring->sq_ring_size) {
+            uring->sq_ring_size = uring->cq_ring_size;
+        }
+        uring->cq_ring_size = uring->sq_ring_size;
+    }
+
+    uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, uring->ring_descriptor, IORING_OFF_SQ_RING);
+
+    if (uring->sq_ring == MAP_FAILED) {
+        LTRACK_E("TeoBase", "Failed to map io_uring submission queue. Error code: %d.", errno);
+        close(uring->ring_descriptor);
+        free(uring);
+        return NULL;
+    }
+
+    if (single_mmap) {
+        uring->cq_ring = uring->sq_ring;
+    } else {
+        uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, uring->ring_descriptor, IORING_OFF_CQ_RING);
+
+        if (uring->cq_ring == MAP_FAILED) {
+            LTRACK_E("TeoBase", "Failed to map io_uring completion queue. Error code: %d.", errno);
+            munmap(uring->sq_ring, uring->sq_ring_size);
+            close(uring->ring_descriptor);
+            free(uring);
+            return NULL;
+        }
+    }
+
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, uring->ring_descriptor, IORING_OFF_SQES);
+
+    if (uring->sqes == MAP_FAILED) {
+        LTRACK_E("TeoBase", "Failed to map io_uring submission entries. Error code: %d.", errno);
+        if (!single_mmap) {
+            munmap(uring->cq_ring, uring->cq_ring_size);
+        }
+        munmap(uring->sq_ring, uring->sq_ring_size);
+        close(uring->ring_descriptor);
+        free(uring);
+        return NULL;
+    }
+
+    uint8_t* sq_ring = uring->sq_ring;
+    uring->sq_head = (unsigned int*)(sq_ring + params.sq_off.head);
+    uring->sq_tail = (unsigned int*)(sq_ring + params.sq_off.tail);
+    uring->sq_array = (unsigned int*)(sq_ring + params.sq_off.array);
+    uring->sq_mask = *(unsigned int*)(sq_ring + params.sq_off.ring_mask);
+    uring->sq_entries = *(unsigned int*)(sq_ring + params.sq_off.ring_entries);
+    uring->sq_local_tail = *uring->sq_tail;
+
+    uint8_t* cq_ring = uring->cq_ring;
+    uring->cq_head = (unsigned int*)(cq_ring + params.cq_off.head);
+    uring->cq_tail = (unsigned int*)(cq_ring + params.cq_off.tail);
+    uring->cq_mask = *(unsigned int*)(cq_ring + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe*)(cq_ring + params.cq_off.cqes);
+
+    return uring;
+}
+
+// Destroys an io_uring instance.
+void teosockUringDestroy(teosockUring* uring) {
+    if (uring == NULL) {
+        return;
+    }
+
+    munmap(uring->sqes, uring->sqes_size);
+    if (uring->cq_ring != uring->sq_ring) {
+        munmap(uring->cq_ring, uring->cq_ring_size);
+    }
+    munmap(uring->sq_ring, uring->sq_ring_size);
+    close(uring->ring_descriptor);
+
+    free(uring);
+}
+
+// Registers buffers to use with fixed buffer operations.
+int teosockUringRegisterBuffers(teosockUring* uring, const teosockIovec* buffers, unsigned int buffers_count) {
+    // teosockIovec has the same layout as struct iovec.
+    int result = teosockUringRegister(uring->ring_descriptor, IORING_REGISTER_BUFFERS, buffers, buffers_count);
+
+    return result == 0 ? TEOSOCK_SOCKET_SUCCESS : TEOSOCK_SOCKET_ERROR;
+}
+
+// Registers sockets to use with TEOSOCK_URING_FIXED_SOCKET flag.
+int teosockUringRegisterSockets(teosockUring* uring, const teonetSocket* sockets, unsigned int sockets_count) {
+    int result = teosockUringRegister(uring->ring_descriptor, IORING_REGISTER_FILES, sockets, sockets_count);
+
+    return result == 0 ? TEOSOCK_SOCKET_SUCCESS : TEOSOCK_SOCKET_ERROR;
+}
+
+// Get next free submission queue entry, or NULL if queue is full.
+static struct io_uring_sqe* teosockUringGetSqe(teosockUring* uring, teonetSocket socket_descriptor, int flags) {
+    unsigned int head = __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (uring->sq_local_tail - head >= uring->sq_entries) {
+        return NULL;
+    }
+
+    unsigned int index = uring->sq_local_tail & uring->sq_mask;
+    struct io_uring_sqe* sqe = &uring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+
+    sqe->fd = socket_descriptor;
+    if (flags & TEOSOCK_URING_FIXED_SOCKET) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+
+    uring->sq_array[index] = index;
+    ++uring->sq_local_tail;
+    ++uring->sq_pending;
+
+    return sqe;
+}
+
+// Limit length to what fits into submission entry. Transfer is reported as short, like a partial send or receive.
+static uint32_t teosockUringClampLength(size_t length) {
+    return length > UINT32_MAX ? UINT32_MAX : (uint32_t)length;
+}
+
+// Queues receiving data from a connected socket.
+int teosockRecvAsync(teosockUring* uring, teonetSocket socket_descriptor, uint8_t* data, size_t length, int flags, uint64_t user_data) {
+    struct io_uring_sqe* sqe = teosockUringGetSqe(uring, socket_descriptor, flags);
+
+    if (sqe == NULL) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = teosockUringClampLength(length);
+    sqe->user_data = user_data;
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Queues sending data on a connected socket.
+int teosockSendAsync(teosockUring* uring, teonetSocket socket_descriptor, const uint8_t* data, size_t length, int flags, uint64_t user_data) {
+    struct io_uring_sqe* sqe = teosockUringGetSqe(uring, socket_descriptor, flags);
+
+    if (sqe == NULL) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = teosockUringClampLength(length);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = user_data;
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Queues receiving a datagram.
+int teosockRecvfromAsync(teosockUring* uring, teonetSocket socket_descriptor, teosockUringRecvfromRequest* request,
+                         uint8_t* buffer, size_t buffer_size, int flags, uint64_t user_data) {
+    struct io_uring_sqe* sqe = teosockUringGetSqe(uring, socket_descriptor, flags);
+
+    if (sqe == NULL) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    memset(&request->header, 0, sizeof(request->header));
+    request->vector.iov_base = buffer;
+    request->vector.iov_len = buffer_size;
+    request->header.msg_name = &request->address;
+    request->header.msg_namelen = sizeof(request->address);
+    request->header.msg_iov = &request->vector;
+    request->header.msg_iovlen = 1;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->addr = (uint64_t)(uintptr_t)&request->header;
+    sqe->len = 1;
+    sqe->user_data = user_data;
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Queues receiving data into a registered buffer.
+int teosockRecvFixedAsync(teosockUring* uring, teonetSocket socket_descriptor, unsigned int buffer_index,
+                          uint8_t* data, size_t length, int flags, uint64_t user_data) {
+    struct io_uring_sqe* sqe = teosockUringGetSqe(uring, socket_descriptor, flags);
+
+    if (sqe == NULL) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    // Offset is ignored for sockets, they are read like pipes.
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = teosockUringClampLength(length);
+    sqe->buf_index = (uint16_t)buffer_index;
+    sqe->user_data = user_data;
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Queues sending data from a registered buffer.
+int teosockSendFixedAsync(teosockUring* uring, teonetSocket socket_descriptor, unsigned int buffer_index,
+                          const uint8_t* data, size_t length, int flags, uint64_t user_data) {
+    struct io_uring_sqe* sqe = teosockUringGetSqe(uring, socket_descriptor, flags);
+
+    if (sqe == NULL) {
+        return TEOSOCK_SOCKET_ERROR;
+    }
+
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = teosockUringClampLength(length);
+    sqe->buf_index = (uint16_t)buffer_index;
+    sqe->user_data = user_data;
+
+    return TEOSOCK_SOCKET_SUCCESS;
+}
+
+// Publish prepared entries and enter the kernel. Returns amount of submitted entries or -1 on error.
+static int teosockUringFlush(teosockUring* uring, unsigned int min_complete, unsigned int flags) {
+    __atomic_store_n(uring->sq_tail, uring->sq_local_tail, __ATOMIC_RELEASE);
+
+    int result;
+    do {
+        result = teosockUringEnter(uring->ring_descriptor, uring->sq_pending, min_complete, flags);
+    } while (result == -1 && errno == EINTR);
+
+    if (result > 0) {
+        uring->sq_pending -= (unsigned int)result;
+    }
+
+    return result;
+}
+
+// Passes all queued operations to the kernel in one system call.
+int teosockUringSubmit(teosockUring* uring) {
+    if (uring->sq_pending == 0) {
+        return 0;
+    }
+
+    int result = teosockUringFlush(uring, 0, 0);
+
+    return result >= 0 ? result : TEOSOCK_SOCKET_ERROR;
+}
+
+// Collects results of completed operations.
+int teosockUringReap(teosockUring* uring, teosockUringCompletion* completions,
+                     unsigned int max_completions, unsigned int min_completions) {
+    unsigned int head = *uring->cq_head;
+    unsigned int tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+    if (min_completions > max_completions) {
+        min_completions = max_completions;
+    }
+
+    // Submit queued operations and wait for missing completions in one system call.
+    if (uring->sq_pending != 0 || tail - head < min_completions) {
+        unsigned int wait_count = tail - head < min_completions ? min_completions - (tail - head) : 0;
+        unsigned int flags = wait_count != 0 ? IORING_ENTER_GETEVENTS : 0;
+
+        if (teosockUringFlush(uring, wait_count, flags) == -1) {
+            return TEOSOCK_SOCKET_ERROR;
+        }
+
+        tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+    }
+
+    unsigned int count = 0;
+
+    while (head != tail && count < max_completions) {
+        const struct io_uring_cqe* cqe = &uring->cqes[head & uring->cq_mask];
+
+        completions[count].user_data = cqe->user_data;
+        completions[count].result = cqe->res;
+
+        ++head;
+        ++count;
+    }
+
+    __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+    return (int)count;
+}